@@ -0,0 +1,123 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+// Producer/consumer throughput of mpmc_queue (blocking and spinning pop) against a mutex + std::deque queue,
+// moving avs_video_frame_ptr handles. The handles are empty, so no AviSynth+ runtime is needed and only the
+// hand-off is measured.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "avs_mpmc_queue.hpp"
+#include "bench_common.hpp"
+
+namespace
+{
+    constexpr int items_per_producer{1'000'000};
+    constexpr std::size_t queue_capacity{64};
+
+    struct item
+    {
+        int n{};
+        avs_helpers::avs_video_frame_ptr frame;
+    };
+
+    class locked_queue
+    {
+    public:
+        void push(item& value)
+        {
+            std::unique_lock lock{mutex_};
+            not_full_.wait(lock, [&] { return items_.size() < queue_capacity; });
+            items_.push_back(std::move(value));
+            not_empty_.notify_one();
+        }
+
+        void pop(item& value)
+        {
+            std::unique_lock lock{mutex_};
+            not_empty_.wait(lock, [&] { return !items_.empty(); });
+            value = std::move(items_.front());
+            items_.pop_front();
+            not_full_.notify_one();
+        }
+
+    private:
+        std::deque<item> items_;
+        std::mutex mutex_;
+        std::condition_variable not_empty_;
+        std::condition_variable not_full_;
+    };
+
+    // Returns million items per second.
+    template<typename Push, typename Pop>
+    double run(const int producers, const int consumers, Push&& push, Pop&& pop)
+    {
+        const int total{producers * items_per_producer};
+        std::atomic<int> remaining{total};
+        std::vector<std::thread> threads;
+
+        const auto start{std::chrono::steady_clock::now()};
+
+        for (int p{0}; p < producers; ++p)
+        {
+            threads.emplace_back([&] {
+                for (int i{0}; i < items_per_producer; ++i)
+                {
+                    item it{i, {}};
+                    push(it);
+                }
+            });
+        }
+
+        for (int c{0}; c < consumers; ++c)
+        {
+            threads.emplace_back([&] {
+                item it;
+                // Each consumer claims an item before popping, so exactly total pops happen.
+                while (remaining.fetch_sub(1, std::memory_order_relaxed) > 0)
+                    pop(it);
+            });
+        }
+
+        for (std::thread& t : threads)
+            t.join();
+
+        const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+        return total / elapsed.count() / 1e6;
+    }
+} // namespace
+
+int main()
+{
+    static const std::atomic<bool> never_stop{false};
+    static constexpr int configs[][2]{{1, 1}, {2, 2}, {4, 4}, {8, 1}, {1, 8}};
+
+    std::printf("%-10s %14s %14s %14s\n", "prod/cons", "mutex+deque", "mpmc (block)", "mpmc (spin)");
+
+    for (const auto& [producers, consumers] : configs)
+    {
+        locked_queue locked;
+        const double locked_rate{run(producers, consumers, [&](item& it) { locked.push(it); }, [&](item& it) { locked.pop(it); })};
+
+        avs_helpers::mpmc_queue<item> blocking{queue_capacity};
+        const double blocking_rate{run(producers, consumers, [&](item& it) { blocking.push(it, never_stop); },
+            [&](item& it) { blocking.pop(it, never_stop); })};
+
+        avs_helpers::mpmc_queue<item> spinning{queue_capacity};
+        const double spinning_rate{run(producers, consumers, [&](item& it) { spinning.push(it, never_stop); }, [&](item& it) {
+            while (!spinning.pop_spin(it, 1024))
+                std::this_thread::yield();
+        })};
+
+        std::printf("%4d/%-5d %11.2f M/s %11.2f M/s %11.2f M/s\n", producers, consumers, locked_rate, blocking_rate, spinning_rate);
+    }
+
+    return 0;
+}
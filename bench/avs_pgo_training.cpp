@@ -0,0 +1,120 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+// PGO training workload.
+// Evaluates synthetic clips in several formats through the loader and pulls frames with the
+// avs_helpers wrappers, exercising the paths plugins use in get_frame (format dispatch, plane access,
+// frame references, pool and arena allocations, value guards).
+// Usage: avs_pgo_training [frames_per_format]
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+
+#include "bench_common.hpp"
+
+namespace
+{
+    constexpr std::string_view required_functions_storage[]{
+        "avs_copy_video_frame",
+        "avs_get_frame",
+        "avs_get_height_p",
+        "avs_get_pitch_p",
+        "avs_get_read_ptr_p",
+        "avs_get_row_size_p",
+        "avs_get_video_info",
+        "avs_invoke",
+        "avs_is_planar_rgb",
+        "avs_is_planar_rgba",
+        "avs_is_y",
+        "avs_num_components",
+        "avs_pool_allocate",
+        "avs_pool_free",
+        "avs_release_clip",
+        "avs_release_value",
+        "avs_release_video_frame",
+        "avs_take_clip",
+    };
+
+    constexpr const char* scripts[]{
+        "BlankClip(length=100000, width=1920, height=1080, pixel_type=\"YV12\", color_yuv=$808080)",
+        "BlankClip(length=100000, width=1920, height=1080, pixel_type=\"YUV422P10\")",
+        "BlankClip(length=100000, width=1280, height=720, pixel_type=\"YUV444PS\")",
+        "BlankClip(length=100000, width=1280, height=720, pixel_type=\"YUVA420P8\")",
+        "BlankClip(length=100000, width=1280, height=720, pixel_type=\"RGBP16\")",
+        "BlankClip(length=100000, width=1280, height=720, pixel_type=\"RGB32\")",
+    };
+
+    constexpr int planes_yuva[]{AVS_PLANAR_Y, AVS_PLANAR_U, AVS_PLANAR_V, AVS_PLANAR_A};
+    constexpr int planes_rgba[]{AVS_PLANAR_G, AVS_PLANAR_B, AVS_PLANAR_R, AVS_PLANAR_A};
+
+    std::uint64_t consume_frame(AVS_ScriptEnvironment* env, const AVS_VideoInfo* vi, const avs_helpers::avs_video_frame_ref& frame)
+    {
+        avs_helpers::frame_arena_scope scope;
+        avs_helpers::avs_pool_memory_resource pool{env};
+        std::pmr::vector<std::uint32_t> row_sums{&pool};
+
+        // Packed and single-plane formats are read through the default plane (0).
+        const bool single_plane{!(vi->pixel_type & AVS_CS_PLANAR) || g_avs_api->avs_is_y(vi)};
+        const bool is_rgb{g_avs_api->avs_is_planar_rgb(vi) || g_avs_api->avs_is_planar_rgba(vi)};
+        const int num_planes{(single_plane) ? 1 : g_avs_api->avs_num_components(vi)};
+        const int* planes{(is_rgb) ? planes_rgba : planes_yuva};
+        std::uint64_t checksum{};
+
+        for (int p{0}; p < num_planes; ++p)
+        {
+            const int plane{(single_plane) ? 0 : planes[p]};
+            const int row_size{g_avs_api->avs_get_row_size_p(frame.get(), plane)};
+            const int height{g_avs_api->avs_get_height_p(frame.get(), plane)};
+            const int pitch{g_avs_api->avs_get_pitch_p(frame.get(), plane)};
+            const BYTE* src{g_avs_api->avs_get_read_ptr_p(frame.get(), plane)};
+
+            std::uint8_t* row{scope.arena().allocate_array<std::uint8_t>(row_size)};
+            row_sums.resize(height);
+
+            for (int y{0}; y < height; ++y)
+            {
+                std::memcpy(row, src + static_cast<std::ptrdiff_t>(y) * pitch, row_size);
+                row_sums[y] = std::accumulate(row, row + row_size, 0u);
+            }
+
+            checksum += std::accumulate(row_sums.begin(), row_sums.end(), std::uint64_t{});
+        }
+
+        return checksum;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int frames{(argc > 1) ? std::atoi(argv[1]) : 200};
+
+    AVS_ScriptEnvironment* env{bench::init_loader(required_functions_storage)};
+    if (!env)
+        return 1;
+
+    std::uint64_t checksum{};
+
+    for (const char* script : scripts)
+    {
+        avs_helpers::avs_clip_ptr clip{bench::eval_clip(env, script)};
+        if (!clip)
+            return 1;
+
+        const AVS_VideoInfo* vi{g_avs_api->avs_get_video_info(clip.get())};
+        avs_helpers::avs_video_frame_ref previous;
+
+        for (int n{0}; n < frames && n < vi->num_frames; ++n)
+        {
+            avs_helpers::avs_video_frame_ref frame{avs_helpers::avs_video_frame_ptr{g_avs_api->avs_get_frame(clip.get(), n)}};
+            checksum += consume_frame(env, vi, frame);
+            previous = frame;
+        }
+    }
+
+    const avs_helpers::frame_arena& arena{avs_helpers::frame_arena::local()};
+    std::printf("checksum %llu, arena high-water %zu bytes\n", static_cast<unsigned long long>(checksum), arena.high_water());
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+// Shared setup for the benchmark and training executables.
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+#include "avs_c_api_loader.hpp"
+
+namespace bench
+{
+    /**
+     * @brief Creates an environment and initializes the loader with the given required functions.
+     * @return The environment, or nullptr on failure (the error is printed).
+     */
+    inline AVS_ScriptEnvironment* init_loader(const std::span<const std::string_view>& required_functions)
+    {
+        static constexpr int REQUIRED_INTERFACE_VERSION{10};
+
+        AVS_ScriptEnvironment* env{
+            avisynth_c_api_loader::create_script_environment(REQUIRED_INTERFACE_VERSION, 0, required_functions)};
+        if (!env)
+            std::fprintf(stderr, "%s\n", avisynth_c_api_loader::get_last_error());
+
+        return env;
+    }
+
+    /**
+     * @brief Evaluates a script and returns the resulting clip.
+     * @return The clip, or an empty avs_clip_ptr on error (the error is printed).
+     */
+    inline avs_helpers::avs_clip_ptr eval_clip(AVS_ScriptEnvironment* env, const char* script)
+    {
+        avs_helpers::avs_value_owner result{g_avs_api->avs_invoke(env, "Eval", avs_new_value_string(script), nullptr)};
+
+        if (avs_is_error(result.get()) || !avs_is_clip(result.get()))
+        {
+            std::fprintf(stderr, "Eval failed: %s\n", avs_is_error(result.get()) ? avs_as_error(result.get()) : "not a clip");
+            return {};
+        }
+
+        return avs_helpers::avs_clip_ptr{g_avs_api->avs_take_clip(result.get(), env)};
+    }
+
+    /**
+     * @brief Runs f() iterations times per round and returns the best average time per call in nanoseconds.
+     */
+    template<typename F>
+    double measure_ns(const int iterations, F&& f, const int rounds = 5)
+    {
+        double best{};
+
+        for (int r{0}; r < rounds; ++r)
+        {
+            const auto start{std::chrono::steady_clock::now()};
+            for (int i{0}; i < iterations; ++i)
+                f();
+            const std::chrono::duration<double, std::nano> elapsed{std::chrono::steady_clock::now() - start};
+
+            const double per_call{elapsed.count() / iterations};
+            if (r == 0 || per_call < best)
+                best = per_call;
+        }
+
+        return best;
+    }
+} // namespace bench
@@ -0,0 +1,108 @@
+# avs_c_api_loader_pgo.cmake - Profile-guided optimization support
+#
+# The AVS_C_API_LOADER_PGO cache variable selects the mode:
+#   OFF      - No PGO (default).
+#   GENERATE - Instrumented build. Running the binaries writes profiles to AVS_C_API_LOADER_PGO_DIR.
+#   USE      - Optimized build using the profiles in AVS_C_API_LOADER_PGO_DIR.
+#
+# The loader target is configured automatically; targets of the same build tree that link it inherit
+# the options (the exported/installed target does not). Plugins built separately can apply the same
+# mode and profile directory to their own targets (so their code is trained and optimized together
+# with the loader):
+#   avs_c_api_loader_apply_pgo(my_plugin PRIVATE)
+#
+# Supported compilers: GCC >= 11 and Clang. Clang profiles must be merged after training; this file
+# does that when run in script mode:
+#   cmake -D AVS_C_API_LOADER_PGO_DIR=<dir> -D LLVM_PROFDATA=<llvm-profdata> -P avs_c_api_loader_pgo.cmake
+
+if(CMAKE_SCRIPT_MODE_FILE)
+  file(GLOB _avs_pgo_raw_files "${AVS_C_API_LOADER_PGO_DIR}/*.profraw")
+  if(_avs_pgo_raw_files)
+    execute_process(
+      COMMAND "${LLVM_PROFDATA}" merge "-output=${AVS_C_API_LOADER_PGO_DIR}/default.profdata" ${_avs_pgo_raw_files}
+      RESULT_VARIABLE _avs_pgo_result
+    )
+    if(NOT _avs_pgo_result EQUAL 0)
+      message(FATAL_ERROR "llvm-profdata merge failed (${_avs_pgo_result}).")
+    endif()
+  else()
+    message(WARNING "No .profraw files found in ${AVS_C_API_LOADER_PGO_DIR}.")
+  endif()
+  return()
+endif()
+
+set(AVS_C_API_LOADER_PGO "OFF" CACHE STRING "Profile-guided optimization mode (OFF, GENERATE, USE)")
+set_property(CACHE AVS_C_API_LOADER_PGO PROPERTY STRINGS OFF GENERATE USE)
+set(AVS_C_API_LOADER_PGO_DIR "${CMAKE_BINARY_DIR}/pgo-profile" CACHE PATH "Directory holding the PGO profiles")
+
+set(_avs_pgo_module_file "${CMAKE_CURRENT_LIST_FILE}")
+
+function(avs_c_api_loader_apply_pgo target scope)
+  if(AVS_C_API_LOADER_PGO STREQUAL "OFF")
+    return()
+  endif()
+
+  set(_dir "${AVS_C_API_LOADER_PGO_DIR}")
+  set(_compile_options "")
+  set(_link_options "")
+
+  if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+    # Strip the build directory from the profile file names so that the instrumented and the
+    # optimized builds (in different build directories) agree on them.
+    if(AVS_C_API_LOADER_PGO STREQUAL "GENERATE")
+      set(_compile_options "-fprofile-generate=${_dir}" -fprofile-update=atomic "-fprofile-prefix-path=${CMAKE_BINARY_DIR}")
+      set(_link_options "-fprofile-generate=${_dir}")
+    elseif(AVS_C_API_LOADER_PGO STREQUAL "USE")
+      set(_compile_options "-fprofile-use=${_dir}" -fprofile-partial-training "-fprofile-prefix-path=${CMAKE_BINARY_DIR}"
+        -Wno-missing-profile)
+    endif()
+  elseif(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+    if(AVS_C_API_LOADER_PGO STREQUAL "GENERATE")
+      set(_compile_options "-fprofile-generate=${_dir}")
+      set(_link_options "-fprofile-generate=${_dir}")
+    elseif(AVS_C_API_LOADER_PGO STREQUAL "USE")
+      set(_compile_options "-fprofile-use=${_dir}/default.profdata" -Wno-profile-instr-unprofiled -Wno-profile-instr-out-of-date)
+    endif()
+  else()
+    message(WARNING "avs_c_api_loader: PGO is not supported for ${CMAKE_CXX_COMPILER_ID}; ignoring AVS_C_API_LOADER_PGO.")
+    return()
+  endif()
+
+  # The options hold absolute paths of this build: propagate them to targets of the same build tree only,
+  # never to the exported/installed target.
+  if(NOT scope STREQUAL "PRIVATE")
+    list(TRANSFORM _compile_options PREPEND "$<BUILD_INTERFACE:")
+    list(TRANSFORM _compile_options APPEND ">")
+    list(TRANSFORM _link_options PREPEND "$<BUILD_INTERFACE:")
+    list(TRANSFORM _link_options APPEND ">")
+  endif()
+
+  if(_compile_options)
+    target_compile_options(${target} ${scope} ${_compile_options})
+  endif()
+  if(_link_options)
+    target_link_options(${target} ${scope} ${_link_options})
+  endif()
+endfunction()
+
+# Adds <name> target that runs the training executable and, for Clang, merges the raw profiles.
+function(avs_c_api_loader_add_pgo_training name training_target)
+  if(NOT AVS_C_API_LOADER_PGO STREQUAL "GENERATE")
+    return()
+  endif()
+
+  set(_commands COMMAND ${CMAKE_COMMAND} -E make_directory "${AVS_C_API_LOADER_PGO_DIR}"
+    COMMAND $<TARGET_FILE:${training_target}> ${ARGN})
+
+  if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+    find_program(LLVM_PROFDATA NAMES llvm-profdata REQUIRED)
+    list(APPEND _commands COMMAND ${CMAKE_COMMAND} "-DAVS_C_API_LOADER_PGO_DIR=${AVS_C_API_LOADER_PGO_DIR}"
+      "-DLLVM_PROFDATA=${LLVM_PROFDATA}" -P "${_avs_pgo_module_file}")
+  endif()
+
+  add_custom_target(${name} ${_commands}
+    DEPENDS ${training_target}
+    COMMENT "Running PGO training workload"
+    VERBATIM
+  )
+endfunction()
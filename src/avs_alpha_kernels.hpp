@@ -0,0 +1,412 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+#include "avs_mask_kernels.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define AVS_HELPERS_ALPHA_SSE2 1
+#else
+#define AVS_HELPERS_ALPHA_SSE2 0
+#endif
+
+namespace avs_helpers
+{
+    namespace detail
+    {
+        // x / (2^bits - 1), rounded, for x <= (2^bits - 1)^2; stays within 32 bits up to 16-bit samples.
+        AVS_FORCEINLINE std::uint32_t div_max(std::uint32_t x, int bits)
+        {
+            const std::uint32_t t{x + (1u << (bits - 1))};
+            return (t + (t >> bits)) >> bits;
+        }
+
+        enum class alpha_op
+        {
+            premultiply,
+            unpremultiply,
+            over
+        };
+
+#if AVS_HELPERS_ALPHA_SSE2
+        // div_max on 32-bit lanes.
+        AVS_FORCEINLINE __m128i alpha_div_max_u32(__m128i x, __m128i half, __m128i shift)
+        {
+            const __m128i t{_mm_add_epi32(x, half)};
+            return _mm_srl_epi32(_mm_add_epi32(t, _mm_srl_epi32(t, shift)), shift);
+        }
+
+        AVS_FORCEINLINE __m128i alpha_clamp_i32(__m128i v, __m128i lo, __m128i hi)
+        {
+            const __m128i below{_mm_cmplt_epi32(v, lo)};
+            v = _mm_or_si128(_mm_and_si128(below, lo), _mm_andnot_si128(below, v));
+            const __m128i above{_mm_cmpgt_epi32(v, hi)};
+            return _mm_or_si128(_mm_and_si128(above, hi), _mm_andnot_si128(above, v));
+        }
+
+        // Unpremultiplies 8 integer samples (16-bit lanes) in float, as the scalar code does; returns 32-bit results.
+        AVS_FORCEINLINE void alpha_unpremultiply_u16x8(__m128i s, __m128i a, __m128 max, __m128 mid, __m128i& lo, __m128i& hi)
+        {
+            const __m128i zero{_mm_setzero_si128()};
+            const __m128 one{_mm_set1_ps(1.0f)};
+
+            const auto half{[&](__m128i sv, __m128i av) {
+                const __m128 af{_mm_cvtepi32_ps(av)};
+                const __m128 visible{_mm_and_ps(_mm_cmpneq_ps(af, _mm_setzero_ps()), one)};
+                const __m128 scale{_mm_mul_ps(_mm_div_ps(max, _mm_add_ps(af, _mm_sub_ps(one, visible))), visible)};
+                const __m128 v{_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(sv), mid), scale), mid), _mm_set1_ps(0.5f))};
+                return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), max));
+            }};
+
+            lo = half(_mm_unpacklo_epi16(s, zero), _mm_unpacklo_epi16(a, zero));
+            hi = half(_mm_unpackhi_epi16(s, zero), _mm_unpackhi_epi16(a, zero));
+        }
+
+        // SSE2 body of alpha_rows for one row: 8 integer or 4 float samples per step, with the same results as the
+        // scalar code. Returns the first sample not processed.
+        template<alpha_op Op, typename T, int SW, int SH>
+        AVS_FORCEINLINE int alpha_row_sse2(T* d, const T* s, const T* b, const T* const (&alpha_rows)[1 << SH], int width, int bits, bool chroma)
+        {
+            int x{0};
+
+            if constexpr (std::is_same_v<T, float>)
+            {
+                const __m128 one{_mm_set1_ps(1.0f)};
+
+                for (; x + 4 <= width; x += 4)
+                {
+                    const __m128 a{mask_block_means_f32_sse2<SW, SH>(alpha_rows, x)};
+                    const __m128 sv{_mm_loadu_ps(s + x)};
+                    __m128 v;
+
+                    if constexpr (Op == alpha_op::premultiply)
+                        v = _mm_mul_ps(sv, a);
+                    else if constexpr (Op == alpha_op::unpremultiply)
+                    {
+                        const __m128 visible{_mm_and_ps(_mm_cmpgt_ps(a, _mm_setzero_ps()), one)};
+                        v = _mm_mul_ps(_mm_div_ps(sv, _mm_add_ps(a, _mm_sub_ps(one, visible))), visible);
+                    }
+                    else
+                        v = _mm_add_ps(sv, _mm_mul_ps(_mm_loadu_ps(b + x), _mm_sub_ps(one, a)));
+
+                    _mm_storeu_ps(d + x, v);
+                }
+            }
+            else if constexpr (std::is_same_v<T, std::uint8_t>)
+            {
+                // Every intermediate fits in unsigned 16-bit lanes: s * a + mid * (255 - a) <= 255 * 255.
+                const __m128i zero{_mm_setzero_si128()};
+                const __m128i max{_mm_set1_epi16(255)};
+                const __m128i mid{_mm_set1_epi16((chroma) ? 128 : 0)};
+                const __m128i round{_mm_set1_epi16(128)};
+                const auto div255{[&](__m128i v) {
+                    const __m128i t{_mm_add_epi16(v, round)};
+                    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+                }};
+
+                for (; x + 8 <= width; x += 8)
+                {
+                    const __m128i a{mask_block_means_u8_sse2<SW, SH>(alpha_rows, x)};
+                    const __m128i sv{_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + x)), zero)};
+                    __m128i v;
+
+                    if constexpr (Op == alpha_op::premultiply)
+                        v = div255(_mm_add_epi16(_mm_mullo_epi16(sv, a), _mm_mullo_epi16(mid, _mm_sub_epi16(max, a))));
+                    else if constexpr (Op == alpha_op::unpremultiply)
+                    {
+                        __m128i lo;
+                        __m128i hi;
+                        alpha_unpremultiply_u16x8(sv, a, _mm_set1_ps(255.0f), _mm_set1_ps((chroma) ? 128.0f : 0.0f), lo, hi);
+                        v = _mm_packs_epi32(lo, hi);
+                    }
+                    else
+                    {
+                        const __m128i bv{_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + x)), zero)};
+                        v = _mm_add_epi16(sv, div255(_mm_add_epi16(_mm_mullo_epi16(bv, _mm_sub_epi16(max, a)), _mm_mullo_epi16(mid, a))));
+                        v = _mm_sub_epi16(_mm_min_epi16(_mm_max_epi16(v, mid), _mm_add_epi16(max, mid)), mid);
+                    }
+
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(d + x), _mm_packus_epi16(v, v));
+                }
+            }
+            else
+            {
+                // 32-bit products and sums; div_max stays within 32 bits up to 16-bit samples.
+                const std::uint32_t max_value{(1u << bits) - 1};
+                const std::uint32_t mid_value{(chroma) ? 1u << (bits - 1) : 0u};
+                const __m128i max{_mm_set1_epi16(static_cast<short>(max_value))};
+                const __m128i mid{_mm_set1_epi16(static_cast<short>(mid_value))};
+                const __m128i half{_mm_set1_epi32(1 << (bits - 1))};
+                const __m128i shift{_mm_cvtsi32_si128(bits)};
+
+                for (; x + 8 <= width; x += 8)
+                {
+                    const __m128i a{mask_block_means_u16_sse2<SW, SH>(alpha_rows, x)};
+                    const __m128i sv{_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + x))};
+                    __m128i lo;
+                    __m128i hi;
+
+                    if constexpr (Op == alpha_op::unpremultiply)
+                        alpha_unpremultiply_u16x8(sv, a, _mm_set1_ps(static_cast<float>(max_value)), _mm_set1_ps(static_cast<float>(mid_value)), lo, hi);
+                    else
+                    {
+                        // premultiply: s * a + mid * (max - a); over: b * (max - a) + mid * a.
+                        const __m128i x0{(Op == alpha_op::premultiply) ? sv : _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x))};
+                        const __m128i w0{(Op == alpha_op::premultiply) ? a : _mm_sub_epi16(max, a)};
+                        const __m128i w1{(Op == alpha_op::premultiply) ? _mm_sub_epi16(max, a) : a};
+
+                        __m128i p_lo;
+                        __m128i p_hi;
+                        __m128i q_lo;
+                        __m128i q_hi;
+                        mask_mul_u16(x0, w0, p_lo, p_hi);
+                        mask_mul_u16(mid, w1, q_lo, q_hi);
+                        lo = alpha_div_max_u32(_mm_add_epi32(p_lo, q_lo), half, shift);
+                        hi = alpha_div_max_u32(_mm_add_epi32(p_hi, q_hi), half, shift);
+
+                        if constexpr (Op == alpha_op::over)
+                        {
+                            const __m128i zero{_mm_setzero_si128()};
+                            const __m128i mid32{_mm_set1_epi32(static_cast<int>(mid_value))};
+                            const __m128i top32{_mm_set1_epi32(static_cast<int>(max_value + mid_value))};
+                            lo = _mm_sub_epi32(alpha_clamp_i32(_mm_add_epi32(lo, _mm_unpacklo_epi16(sv, zero)), mid32, top32), mid32);
+                            hi = _mm_sub_epi32(alpha_clamp_i32(_mm_add_epi32(hi, _mm_unpackhi_epi16(sv, zero)), mid32, top32), mid32);
+                        }
+                    }
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(d + x), mask_pack_u32(lo, hi));
+                }
+            }
+
+            return x;
+        }
+#endif
+
+        // Integer samples: alpha is 0..max (max = 2^bits - 1); chroma planes are premultiplied around the
+        // neutral value mid = 2^(bits - 1). Float samples: alpha is 0..1 and chroma is centred on 0.
+        // For over, src is the premultiplied foreground and bg the background (dst may alias bg or src).
+        template<alpha_op Op, typename T, int SW, int SH>
+        AVS_FORCEINLINE void alpha_rows(plane_view<T> dst, plane_view<const T> src, plane_view<const T> alpha, plane_view<const T> bg,
+            int bits, bool chroma)
+        {
+            const std::uint32_t max{(1u << bits) - 1};
+            const std::uint32_t mid{(chroma) ? 1u << (bits - 1) : 0u};
+
+            for (int y{0}; y < dst.height; ++y)
+            {
+                const T* alpha_rows[1 << SH];
+                for (int k{0}; k < (1 << SH); ++k)
+                    alpha_rows[k] = alpha.row((y << SH) + k);
+
+                T* d{dst.row(y)};
+                const T* s{src.row(y)};
+                const T* b{(Op == alpha_op::over) ? bg.row(y) : nullptr};
+
+                int x{0};
+#if AVS_HELPERS_ALPHA_SSE2
+                // Not vectorized by compilers at -O2 (and the 16-bit products need 32-bit lanes).
+                x = alpha_row_sse2<Op, T, SW, SH>(d, s, b, alpha_rows, dst.width, bits, chroma);
+#endif
+
+                for (; x < dst.width; ++x)
+                {
+                    const auto a{mask_block_mean<T, SW, SH>(alpha_rows, x)};
+
+                    if constexpr (std::is_same_v<T, float>)
+                    {
+                        if constexpr (Op == alpha_op::premultiply)
+                            d[x] = s[x] * a;
+                        else if constexpr (Op == alpha_op::unpremultiply)
+                        {
+                            // Branch-free (a divide under a condition keeps the loop scalar).
+                            const bool visible{a > 0.0f};
+                            d[x] = s[x] / (a + static_cast<float>(!visible)) * static_cast<float>(visible);
+                        }
+                        else
+                            d[x] = s[x] + b[x] * (1.0f - a);
+                    }
+                    else if constexpr (Op == alpha_op::premultiply)
+                        d[x] = static_cast<T>(div_max(s[x] * a + mid * (max - a), bits));
+                    else if constexpr (Op == alpha_op::unpremultiply)
+                    {
+                        const bool visible{a != 0};
+                        const float scale{static_cast<float>(max) / static_cast<float>(a + !visible) * static_cast<float>(visible)};
+                        const float v{(static_cast<float>(s[x]) - static_cast<float>(mid)) * scale + static_cast<float>(mid) + 0.5f};
+                        d[x] = static_cast<T>(std::min(std::max(v, 0.0f), static_cast<float>(max)));
+                    }
+                    else
+                    {
+                        // fg + (bg - mid) * (1 - a): the background term stays non-negative when mid * a is added.
+                        const std::uint32_t v{s[x] + div_max(b[x] * (max - a) + mid * a, bits)};
+                        d[x] = static_cast<T>(std::min(std::max(v, mid), max + mid) - mid);
+                    }
+                }
+            }
+        }
+
+        template<alpha_op Op, typename T>
+        AVS_FORCEINLINE bool alpha_dispatch(plane_view<T> dst, plane_view<const T> src, plane_view<const T> alpha, plane_view<const T> bg,
+            int sub_w, int sub_h, int bits, bool chroma)
+        {
+            switch ((sub_w << 2) | sub_h)
+            {
+            case (0 << 2) | 0:
+                alpha_rows<Op, T, 0, 0>(dst, src, alpha, bg, bits, chroma);
+                return true;
+            case (1 << 2) | 0:
+                alpha_rows<Op, T, 1, 0>(dst, src, alpha, bg, bits, chroma);
+                return true;
+            case (1 << 2) | 1:
+                alpha_rows<Op, T, 1, 1>(dst, src, alpha, bg, bits, chroma);
+                return true;
+            case (2 << 2) | 0:
+                alpha_rows<Op, T, 2, 0>(dst, src, alpha, bg, bits, chroma);
+                return true;
+            default:
+                return false;
+            }
+        }
+    } // namespace detail
+
+    /**
+     * @brief Premultiplies a colour plane by a full-resolution alpha plane (AVS_PLANAR_A); dst may be src.
+     * Subsampled planes use the mean alpha of each block. Chroma planes of integer YUV are scaled around the
+     * neutral value.
+     * @param sub_w, sub_h log2 subsampling of the plane (0 for luma, RGB and the alpha plane itself).
+     * @param bits Bits per sample of integer formats.
+     * @param chroma true for the U and V planes of YUV.
+     * @return false if the subsampling is not supported.
+     */
+    AVS_HELPERS_KERNEL inline bool premultiply_plane(plane_view<std::uint8_t> dst, plane_view<const std::uint8_t> src,
+        plane_view<const std::uint8_t> alpha, int sub_w, int sub_h, bool chroma)
+    {
+        return detail::alpha_dispatch<detail::alpha_op::premultiply>(dst, src, alpha, {}, sub_w, sub_h, 8, chroma);
+    }
+
+    AVS_HELPERS_KERNEL inline bool premultiply_plane(plane_view<std::uint16_t> dst, plane_view<const std::uint16_t> src,
+        plane_view<const std::uint16_t> alpha, int sub_w, int sub_h, int bits, bool chroma)
+    {
+        return detail::alpha_dispatch<detail::alpha_op::premultiply>(dst, src, alpha, {}, sub_w, sub_h, bits, chroma);
+    }
+
+    AVS_HELPERS_KERNEL inline bool premultiply_plane(
+        plane_view<float> dst, plane_view<const float> src, plane_view<const float> alpha, int sub_w, int sub_h)
+    {
+        return detail::alpha_dispatch<detail::alpha_op::premultiply>(dst, src, alpha, {}, sub_w, sub_h, 1, false);
+    }
+
+    /**
+     * @brief Reverses premultiply_plane; samples with zero alpha become 0 (the neutral value for chroma).
+     */
+    AVS_HELPERS_KERNEL inline bool unpremultiply_plane(plane_view<std::uint8_t> dst, plane_view<const std::uint8_t> src,
+        plane_view<const std::uint8_t> alpha, int sub_w, int sub_h, bool chroma)
+    {
+        return detail::alpha_dispatch<detail::alpha_op::unpremultiply>(dst, src, alpha, {}, sub_w, sub_h, 8, chroma);
+    }
+
+    AVS_HELPERS_KERNEL inline bool unpremultiply_plane(plane_view<std::uint16_t> dst, plane_view<const std::uint16_t> src,
+        plane_view<const std::uint16_t> alpha, int sub_w, int sub_h, int bits, bool chroma)
+    {
+        return detail::alpha_dispatch<detail::alpha_op::unpremultiply>(dst, src, alpha, {}, sub_w, sub_h, bits, chroma);
+    }
+
+    AVS_HELPERS_KERNEL inline bool unpremultiply_plane(
+        plane_view<float> dst, plane_view<const float> src, plane_view<const float> alpha, int sub_w, int sub_h)
+    {
+        return detail::alpha_dispatch<detail::alpha_op::unpremultiply>(dst, src, alpha, {}, sub_w, sub_h, 1, false);
+    }
+
+    /**
+     * @brief Porter-Duff "over" of a premultiplied foreground plane onto a background plane:
+     * dst = fg + bg * (1 - fg_alpha). Applied to the alpha planes themselves (fg = fg_alpha) it gives the
+     * composite alpha. dst may be fg or bg.
+     */
+    AVS_HELPERS_KERNEL inline bool over_plane(plane_view<std::uint8_t> dst, plane_view<const std::uint8_t> fg,
+        plane_view<const std::uint8_t> fg_alpha, plane_view<const std::uint8_t> bg, int sub_w, int sub_h, bool chroma)
+    {
+        return detail::alpha_dispatch<detail::alpha_op::over>(dst, fg, fg_alpha, bg, sub_w, sub_h, 8, chroma);
+    }
+
+    AVS_HELPERS_KERNEL inline bool over_plane(plane_view<std::uint16_t> dst, plane_view<const std::uint16_t> fg,
+        plane_view<const std::uint16_t> fg_alpha, plane_view<const std::uint16_t> bg, int sub_w, int sub_h, int bits, bool chroma)
+    {
+        return detail::alpha_dispatch<detail::alpha_op::over>(dst, fg, fg_alpha, bg, sub_w, sub_h, bits, chroma);
+    }
+
+    AVS_HELPERS_KERNEL inline bool over_plane(plane_view<float> dst, plane_view<const float> fg, plane_view<const float> fg_alpha,
+        plane_view<const float> bg, int sub_w, int sub_h)
+    {
+        return detail::alpha_dispatch<detail::alpha_op::over>(dst, fg, fg_alpha, bg, sub_w, sub_h, 1, false);
+    }
+
+    namespace detail
+    {
+        // Applies an alpha kernel to every plane of frames with alpha (alpha is the last plane).
+        template<alpha_op Op>
+        bool alpha_frame(const frame_view& dst, const frame_view& src, const frame_view* bg)
+        {
+            if (src.num_planes != 4)
+                return false;
+
+            const bool yuv{src.planes[0] == AVS_PLANAR_Y};
+
+            // The alpha plane of premultiply/unpremultiply is left as is; over composites it last, after the
+            // colour planes have read the foreground alpha.
+            const int planes{(Op == alpha_op::over) ? 4 : 3};
+            for (int i{0}; i < planes; ++i)
+            {
+                const bool chroma{yuv && (i == 1 || i == 2)};
+                bool ok;
+
+                if (src.bits == 8)
+                    ok = alpha_dispatch<Op, std::uint8_t>(dst.write<std::uint8_t>(i), src.read<std::uint8_t>(i), src.read<std::uint8_t>(3),
+                        (bg) ? bg->read<std::uint8_t>(i) : plane_view<const std::uint8_t>{}, src.sub_w[i], src.sub_h[i], 8, chroma);
+                else if (src.bits == 32)
+                    ok = alpha_dispatch<Op, float>(dst.write<float>(i), src.read<float>(i), src.read<float>(3),
+                        (bg) ? bg->read<float>(i) : plane_view<const float>{}, src.sub_w[i], src.sub_h[i], 1, false);
+                else
+                    ok = alpha_dispatch<Op, std::uint16_t>(dst.write<std::uint16_t>(i), src.read<std::uint16_t>(i),
+                        src.read<std::uint16_t>(3), (bg) ? bg->read<std::uint16_t>(i) : plane_view<const std::uint16_t>{}, src.sub_w[i],
+                        src.sub_h[i], src.bits, chroma);
+
+                if (!ok)
+                    return false;
+            }
+
+            return true;
+        }
+    } // namespace detail
+
+    /**
+     * @brief Premultiplies the colour planes of a YUVA or planar RGBA frame by its alpha plane.
+     * @param dst Writable frame of the same format (may be src's frame).
+     * @return false if the format has no alpha plane or the subsampling is not supported.
+     */
+    inline bool premultiply(const frame_view& dst, const frame_view& src)
+    {
+        return detail::alpha_frame<detail::alpha_op::premultiply>(dst, src, nullptr);
+    }
+
+    /**
+     * @brief Reverses premultiply.
+     */
+    inline bool unpremultiply(const frame_view& dst, const frame_view& src)
+    {
+        return detail::alpha_frame<detail::alpha_op::unpremultiply>(dst, src, nullptr);
+    }
+
+    /**
+     * @brief Composites a premultiplied foreground over a background of the same format, including the alpha plane.
+     * @param dst Writable frame of the same format (may be the background's frame).
+     */
+    inline bool over(const frame_view& dst, const frame_view& fg, const frame_view& bg)
+    {
+        return detail::alpha_frame<detail::alpha_op::over>(dst, fg, &bg);
+    }
+} // namespace avs_helpers
@@ -0,0 +1,238 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+#include "avs_cpu_dispatch.hpp"
+#include "avs_frame_view.hpp"
+
+namespace avs_helpers
+{
+    /** Largest radius box_blur_plane accepts (the integer window sum stays within 32 bits at 16-bit). */
+    inline constexpr int box_blur_max_radius{16383};
+
+    namespace detail
+    {
+        // Rounded sum / n for integer window sums of up to 65535 * n, as ((sum + n / 2) * mul) >> shift.
+        // With shift = 16 + 2 * bit_width(n), mul = ceil(2^shift / n) is exact for that range (the rounding error
+        // of mul times the largest sum stays below 2^shift) and mul fits in 32 bits up to n < 2^15, so the
+        // product is a 32 x 32 -> 64-bit multiply that compilers vectorize.
+        struct box_divider
+        {
+            std::uint32_t half;
+            std::uint32_t mul;
+            int shift;
+
+            explicit box_divider(int n) noexcept
+                : half(static_cast<std::uint32_t>(n) / 2), shift(16 + 2 * static_cast<int>(std::bit_width(static_cast<unsigned>(n))))
+            {
+                mul = static_cast<std::uint32_t>(((std::uint64_t{1} << shift) + static_cast<std::uint64_t>(n) - 1) / static_cast<std::uint64_t>(n));
+            }
+
+            AVS_FORCEINLINE std::uint32_t operator()(std::uint32_t sum) const noexcept
+            {
+                return static_cast<std::uint32_t>((static_cast<std::uint64_t>(sum + half) * mul) >> shift);
+            }
+        };
+
+        // Integer samples sum in 32 bits (no overflow for 16-bit samples up to box_blur_max_radius); float sums in
+        // double so that the running sum does not drift along a 4K row.
+        template<typename T>
+        using box_sum_t = std::conditional_t<std::is_same_v<T, float>, double, std::uint32_t>;
+
+        // Vertical pass with a column-accumulator row: acc holds the window sum of every column and is updated by
+        // one entering and one leaving row per output row. Edges are replicated.
+        template<typename T>
+        AVS_FORCEINLINE void box_blur_vertical(plane_view<T> dst, plane_view<const T> src, int radius, box_sum_t<T>* acc)
+        {
+            using S = box_sum_t<T>;
+
+            const int width{src.width};
+            const int last{src.height - 1};
+            const int n{2 * radius + 1};
+            const box_divider div{n};
+            const double scale{1.0 / n};
+
+            for (int x{0}; x < width; ++x)
+                acc[x] = static_cast<S>(src.row(0)[x]) * static_cast<S>(radius + 1);
+            for (int k{1}; k <= radius; ++k)
+            {
+                const T* s{src.row(std::min(k, last))};
+                for (int x{0}; x < width; ++x)
+                    acc[x] += s[x];
+            }
+
+            for (int y{0}; y <= last; ++y)
+            {
+                T* d{dst.row(y)};
+                const T* enter{src.row(std::min(y + radius + 1, last))};
+                const T* leave{src.row(std::max(y - radius, 0))};
+
+                for (int x{0}; x < width; ++x)
+                {
+                    if constexpr (std::is_same_v<T, float>)
+                        d[x] = static_cast<float>(acc[x] * scale);
+                    else
+                        d[x] = static_cast<T>(div(acc[x]));
+
+                    acc[x] += static_cast<S>(enter[x]);
+                    acc[x] -= static_cast<S>(leave[x]);
+                }
+            }
+        }
+
+        // Horizontal pass in place with a running sum over a copy of the row padded by radius replicated samples
+        // on each side (padded holds width + 2 * radius + 1 samples).
+        template<typename T>
+        AVS_FORCEINLINE void box_blur_horizontal(plane_view<T> plane, int radius, T* padded)
+        {
+            using S = box_sum_t<T>;
+
+            const int width{plane.width};
+            const int n{2 * radius + 1};
+            const box_divider div{n};
+            const double scale{1.0 / n};
+
+            for (int y{0}; y < plane.height; ++y)
+            {
+                T* d{plane.row(y)};
+
+                std::fill_n(padded, radius, d[0]);
+                std::copy_n(d, width, padded + radius);
+                std::fill_n(padded + radius + width, radius + 1, d[width - 1]);
+
+                S sum{};
+                for (int i{0}; i < n; ++i)
+                    sum += padded[i];
+
+                for (int x{0}; x < width; ++x)
+                {
+                    if constexpr (std::is_same_v<T, float>)
+                        d[x] = static_cast<float>(sum * scale);
+                    else
+                        d[x] = static_cast<T>(div(sum));
+
+                    sum += static_cast<S>(padded[x + n]);
+                    sum -= static_cast<S>(padded[x]);
+                }
+            }
+        }
+
+        template<typename T>
+        AVS_FORCEINLINE bool box_blur(plane_view<T> dst, plane_view<const T> src, int radius_x, int radius_y)
+        {
+            if (dst.width != src.width || dst.height != src.height || radius_x < 0 || radius_y < 0 || radius_x > box_blur_max_radius ||
+                radius_y > box_blur_max_radius)
+                return false;
+
+            frame_arena_scope scope;
+            frame_arena& arena{scope.arena()};
+
+            box_sum_t<T>* acc{arena.allocate_array<box_sum_t<T>>(static_cast<std::size_t>(src.width))};
+            box_blur_vertical(dst, src, radius_y, acc);
+
+            if (radius_x > 0)
+                box_blur_horizontal(dst, radius_x, arena.allocate_array<T>(static_cast<std::size_t>(src.width) + 2 * radius_x + 1));
+
+            return true;
+        }
+    } // namespace detail
+
+    /**
+     * @brief Box blur of a plane in O(1) per sample for any radius: the mean of the (2 * radius_x + 1) x
+     * (2 * radius_y + 1) window around each sample, with replicated edges and rounding to nearest.
+     * The vertical pass keeps a column-accumulator row, the horizontal pass a running sum. Integer sums are
+     * 32-bit (exact at 16-bit for radii up to box_blur_max_radius); float sums are double.
+     * Scratch memory comes from the calling thread's frame_arena.
+     * @param dst Plane of the size of src; must not overlap src.
+     * @return false if the sizes do not match or a radius is out of range.
+     */
+    AVS_HELPERS_KERNEL inline bool box_blur_plane(plane_view<std::uint8_t> dst, plane_view<const std::uint8_t> src, int radius_x, int radius_y)
+    {
+        return detail::box_blur(dst, src, radius_x, radius_y);
+    }
+
+    AVS_HELPERS_KERNEL inline bool box_blur_plane(plane_view<std::uint16_t> dst, plane_view<const std::uint16_t> src, int radius_x, int radius_y)
+    {
+        return detail::box_blur(dst, src, radius_x, radius_y);
+    }
+
+    AVS_HELPERS_KERNEL inline bool box_blur_plane(plane_view<float> dst, plane_view<const float> src, int radius_x, int radius_y)
+    {
+        return detail::box_blur(dst, src, radius_x, radius_y);
+    }
+
+    /**
+     * @brief Gets the radius of pass `pass` of `passes` box blurs that together approximate a Gaussian of the
+     * given sigma (the widths are the two odd integers around sqrt(12 * sigma^2 / passes + 1), mixed so that the
+     * variances add up to sigma^2).
+     */
+    inline int gaussian_box_radius(double sigma, int passes, int pass)
+    {
+        const double ideal{std::sqrt(12.0 * sigma * sigma / passes + 1.0)};
+        int lower{static_cast<int>(std::floor(ideal))};
+        if (!(lower & 1))
+            --lower;
+        lower = std::max(lower, 1);
+
+        const double lower_passes{
+            std::round((12.0 * sigma * sigma - passes * lower * lower - 4.0 * passes * lower - 3.0 * passes) / (-4.0 * lower - 4.0))};
+
+        return ((pass < lower_passes) ? lower : lower + 2) / 2;
+    }
+
+    namespace detail
+    {
+        template<typename T>
+        bool gaussian_blur(plane_view<T> dst, plane_view<const T> src, double sigma, int passes)
+        {
+            if (passes < 1 || dst.width != src.width || dst.height != src.height)
+                return false;
+
+            frame_arena_scope scope;
+            const plane_view<T> tmp{(passes > 1) ? arena_plane<T>(scope.arena(), src.width, src.height) : plane_view<T>{}};
+
+            // Ping-pong between dst and tmp so that the last pass writes dst.
+            plane_view<const T> in{src};
+            for (int i{0}; i < passes; ++i)
+            {
+                const plane_view<T> out{((passes - 1 - i) & 1) ? tmp : dst};
+                const int radius{gaussian_box_radius(sigma, passes, i)};
+
+                if (!box_blur_plane(out, in, radius, radius))
+                    return false;
+
+                in = out;
+            }
+
+            return true;
+        }
+    } // namespace detail
+
+    /**
+     * @brief Approximates a Gaussian blur with `passes` box blurs (3 passes are within a few percent of a true
+     * Gaussian). The cost does not depend on sigma.
+     * @param dst Plane of the size of src; must not overlap src.
+     * @return false if the sizes do not match, passes < 1 or a box radius is out of range.
+     */
+    inline bool gaussian_blur_plane(plane_view<std::uint8_t> dst, plane_view<const std::uint8_t> src, double sigma, int passes = 3)
+    {
+        return detail::gaussian_blur(dst, src, sigma, passes);
+    }
+
+    inline bool gaussian_blur_plane(plane_view<std::uint16_t> dst, plane_view<const std::uint16_t> src, double sigma, int passes = 3)
+    {
+        return detail::gaussian_blur(dst, src, sigma, passes);
+    }
+
+    inline bool gaussian_blur_plane(plane_view<float> dst, plane_view<const float> src, double sigma, int passes = 3)
+    {
+        return detail::gaussian_blur(dst, src, sigma, passes);
+    }
+} // namespace avs_helpers
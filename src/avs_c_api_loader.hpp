@@ -11,9 +11,13 @@ namespace avs_loader_meta
     constexpr const char* VERSION_STRING = "1.1.0";
 } // namespace avs_loader_meta
 
+#include <array>
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
+#include <new>
 #include <optional>
 #include <span>
 #include <string>
@@ -35,6 +39,14 @@ namespace avs_loader_meta
 
 #include <avisynth_c.h>
 
+// Header-only mode: the loader definitions are included at the end of this header and marked inline,
+// so the whole loader is visible to the plugin's optimizer (inlining and LTO).
+#ifdef AVS_C_API_LOADER_HEADER_ONLY
+#define AVS_C_API_LOADER_INLINE inline
+#else
+#define AVS_C_API_LOADER_INLINE
+#endif
+
 struct avisynth_c_api_pointers
 {
 #define FUNC(name)                    \
@@ -59,6 +71,21 @@ public:
     static const avisynth_c_api_pointers* get_api(AVS_ScriptEnvironment* env, const int required_interface_version,
         const int required_bugfix_version, const std::span<const std::string_view>& required_function_names);
 
+    /**
+     * @brief Creates a script environment for host applications (which, unlike plugins, are not handed one)
+     * and initializes the API for it, as get_api does.
+     * The Avisynth library stays loaded for the lifetime of the process, since the environment's
+     * at-exit callbacks run from inside it.
+     * @param required_interface_version Interface version requested from avs_create_script_environment and
+     * minimum version checked by get_api.
+     * @param required_bugfix_version Minimum AVISYNTHPLUS_INTERFACE_BUGFIX_VERSION needed for the required_interface_version.
+     * @param required_function_names List of function names absolutely required by the host.
+     * @return The new environment on success (release it with g_avs_api->avs_delete_script_environment),
+     * nullptr on failure. Check get_last_error() on failure.
+     */
+    static AVS_ScriptEnvironment* create_script_environment(const int required_interface_version,
+        const int required_bugfix_version, const std::span<const std::string_view>& required_function_names);
+
     /**
      * @brief Gets the last error message if get_api returned nullptr.
      * @return A static C-string pointer containing the error description. Valid until the next call to get_api.
@@ -135,6 +162,165 @@ namespace avs_helpers
     /** @brief std::unique_ptr alias for an AVS_VideoFrame managed by avs_video_frame_deleter. */
     using avs_video_frame_ptr = std::unique_ptr<AVS_VideoFrame, avs_video_frame_deleter>;
 
+    /**
+     * @brief Copyable, single-pointer reference to an Avisynth handle.
+     * Copying takes a new reference through Traits::copy (e.g. avs_copy_video_frame),
+     * destruction drops it through Traits::release (e.g. avs_release_video_frame).
+     * @tparam T The handle type (AVS_VideoFrame or AVS_Clip).
+     * @tparam Traits Provides static T* copy(T*) and static void release(T*).
+     */
+    template<typename T, typename Traits>
+    class avs_handle_ref
+    {
+    public:
+        /**
+         * @brief Default constructor. Initializes to an empty reference.
+         */
+        avs_handle_ref() noexcept = default;
+
+        /**
+         * @brief Constructs a reference adopting an already owned handle (no extra reference is taken).
+         * @param handle The handle to adopt. May be nullptr.
+         */
+        explicit avs_handle_ref(T* handle) noexcept
+            : handle_(handle)
+        {
+        }
+
+        /**
+         * @brief Constructs a reference adopting the handle owned by a std::unique_ptr.
+         * @param handle The unique_ptr to take the handle from. It is left empty.
+         */
+        template<typename Deleter>
+        explicit avs_handle_ref(std::unique_ptr<T, Deleter>&& handle) noexcept
+            : handle_(handle.release())
+        {
+        }
+
+        ~avs_handle_ref()
+        {
+            if (handle_)
+                Traits::release(handle_);
+        }
+
+        avs_handle_ref(const avs_handle_ref& other) noexcept
+            : handle_(other.handle_ ? Traits::copy(other.handle_) : nullptr)
+        {
+        }
+
+        avs_handle_ref(avs_handle_ref&& other) noexcept
+            : handle_(other.handle_)
+        {
+            other.handle_ = nullptr;
+        }
+
+        avs_handle_ref& operator=(const avs_handle_ref& other) noexcept
+        {
+            if (this != &other)
+                reset(other.handle_ ? Traits::copy(other.handle_) : nullptr);
+
+            return *this;
+        }
+
+        avs_handle_ref& operator=(avs_handle_ref&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset(other.handle_);
+                other.handle_ = nullptr;
+            }
+
+            return *this;
+        }
+
+        /**
+         * @brief Gets the managed handle. Does not affect ownership.
+         */
+        T* get() const noexcept
+        {
+            return handle_;
+        }
+
+        /**
+         * @brief Releases ownership of the managed handle and returns it.
+         * The caller is now responsible for releasing the returned handle.
+         */
+        T* release() noexcept
+        {
+            T* temp{handle_};
+            handle_ = nullptr;
+
+            return temp;
+        }
+
+        /**
+         * @brief Drops the current reference (if any) and adopts a new handle.
+         * @param handle The handle to adopt. May be nullptr.
+         */
+        void reset(T* handle = nullptr) noexcept
+        {
+            T* old{handle_};
+            handle_ = handle;
+            if (old)
+                Traits::release(old);
+        }
+
+        void swap(avs_handle_ref& other) noexcept
+        {
+            T* temp{handle_};
+            handle_ = other.handle_;
+            other.handle_ = temp;
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return handle_ != nullptr;
+        }
+
+        friend bool operator==(const avs_handle_ref& lhs, const avs_handle_ref& rhs) noexcept
+        {
+            return lhs.handle_ == rhs.handle_;
+        }
+
+    private:
+        T* handle_{};
+    };
+
+    /** @brief Reference traits for AVS_VideoFrame (avs_copy_video_frame/avs_release_video_frame). */
+    struct avs_video_frame_ref_traits
+    {
+        static AVS_VideoFrame* copy(AVS_VideoFrame* frame) noexcept
+        {
+            return g_avs_api->avs_copy_video_frame(frame);
+        }
+
+        static void release(AVS_VideoFrame* frame) noexcept
+        {
+            g_avs_api->avs_release_video_frame(frame);
+        }
+    };
+    /** @brief Copyable reference to an AVS_VideoFrame. Copies share the frame via avs_copy_video_frame. */
+    using avs_video_frame_ref = avs_handle_ref<AVS_VideoFrame, avs_video_frame_ref_traits>;
+
+    /** @brief Reference traits for AVS_Clip (avs_copy_clip/avs_release_clip). */
+    struct avs_clip_ref_traits
+    {
+        static AVS_Clip* copy(AVS_Clip* clip) noexcept
+        {
+            return g_avs_api->avs_copy_clip(clip);
+        }
+
+        static void release(AVS_Clip* clip) noexcept
+        {
+            g_avs_api->avs_release_clip(clip);
+        }
+    };
+    /** @brief Copyable reference to an AVS_Clip. Copies share the clip via avs_copy_clip. */
+    using avs_clip_ref = avs_handle_ref<AVS_Clip, avs_clip_ref_traits>;
+
+    static_assert(sizeof(avs_video_frame_ref) == sizeof(AVS_VideoFrame*));
+    static_assert(sizeof(avs_clip_ref) == sizeof(AVS_Clip*));
+
     /**
      * @brief Deleter for memory allocated by avs_pool_allocate, to be used with std::unique_ptr.
      * Calls g_avs_api->avs_pool_free on destruction. Requires the AVS_ScriptEnvironment
@@ -154,6 +340,279 @@ namespace avs_helpers
     /** @brief std::unique_ptr alias for memory from avs_pool_allocate managed by avs_pool_deleter. */
     using avs_pool_ptr = std::unique_ptr<std::byte[], avs_pool_deleter>;
 
+    /**
+     * @brief std::pmr::memory_resource backed by avs_pool_allocate/avs_pool_free of one environment.
+     * Lets std::pmr containers (std::pmr::vector, std::pmr::string, ...) draw from the host pool.
+     * Requested alignments below alignof(std::max_align_t) are raised to it.
+     * The environment must outlive the resource and every allocation made from it.
+     */
+    class avs_pool_memory_resource : public std::pmr::memory_resource
+    {
+    public:
+        /**
+         * @brief Constructs a resource allocating from the given environment's pool.
+         * @param env The AVS_ScriptEnvironment pointer used for avs_pool_allocate/avs_pool_free.
+         */
+        explicit avs_pool_memory_resource(AVS_ScriptEnvironment* env) noexcept
+            : env_(env)
+        {
+        }
+
+        avs_pool_memory_resource(const avs_pool_memory_resource&) = delete;
+        avs_pool_memory_resource& operator=(const avs_pool_memory_resource&) = delete;
+
+        /**
+         * @brief Gets the environment the resource allocates from.
+         * @return The AVS_ScriptEnvironment pointer.
+         */
+        AVS_ScriptEnvironment* env() const noexcept
+        {
+            return env_;
+        }
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override
+        {
+            void* ptr{g_avs_api->avs_pool_allocate(env_, (bytes) ? bytes : 1,
+                (alignment < alignof(std::max_align_t)) ? alignof(std::max_align_t) : alignment)};
+
+            if (!ptr)
+                throw std::bad_alloc();
+
+            return ptr;
+        }
+
+        void do_deallocate(void* ptr, std::size_t /*bytes*/, std::size_t /*alignment*/) override
+        {
+            g_avs_api->avs_pool_free(env_, ptr);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            const auto* other_pool{dynamic_cast<const avs_pool_memory_resource*>(&other)};
+
+            return other_pool && other_pool->env_ == env_;
+        }
+
+        AVS_ScriptEnvironment* env_;
+    };
+
+    /**
+     * @brief Monotonic arena for temporary allocations made while producing one frame.
+     * Memory comes from preallocated aligned slabs that are kept between frames, so the steady-state
+     * frame path does not touch the heap. Usable directly or as a std::pmr::memory_resource.
+     * Not thread-safe; use one arena per thread (see frame_arena::local()).
+     */
+    class frame_arena : public std::pmr::memory_resource
+    {
+    public:
+        static constexpr std::size_t default_slab_size{std::size_t{1} << 20};
+        static constexpr std::size_t slab_alignment{64};
+
+        /**
+         * @brief Position in the arena, used to rewind nested scopes.
+         */
+        struct mark
+        {
+            std::size_t slab{};
+            std::size_t offset{};
+            std::size_t used{};
+        };
+
+        /**
+         * @brief Constructs an arena. The first slab is allocated on the first allocation.
+         * @param slab_size Size in bytes of each preallocated slab.
+         */
+        explicit frame_arena(std::size_t slab_size = default_slab_size) noexcept
+            : slab_size_(slab_size)
+        {
+        }
+
+        ~frame_arena()
+        {
+            for (const slab& s : slabs_)
+                ::operator delete(s.data, std::align_val_t{s.alignment});
+        }
+
+        frame_arena(const frame_arena&) = delete;
+        frame_arena& operator=(const frame_arena&) = delete;
+
+        /**
+         * @brief Allocates uninitialized storage for n objects of type T.
+         * @return Pointer to the storage, valid until the arena is rewound past it.
+         */
+        template<typename T>
+        T* allocate_array(std::size_t n)
+        {
+            return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+        }
+
+        /**
+         * @brief Gets the current position. Pass it to rewind() to release everything allocated after it.
+         */
+        mark get_mark() const noexcept
+        {
+            return {current_, offset_, used_};
+        }
+
+        /**
+         * @brief Releases all allocations made after the given mark. The slabs are kept.
+         */
+        void rewind(const mark& m) noexcept
+        {
+            current_ = m.slab;
+            offset_ = m.offset;
+            used_ = m.used;
+        }
+
+        /**
+         * @brief Releases all allocations. The slabs are kept for the next frame.
+         */
+        void reset() noexcept
+        {
+            rewind({});
+        }
+
+        /** @brief Bytes currently allocated (including alignment padding). */
+        std::size_t used() const noexcept
+        {
+            return used_;
+        }
+
+        /** @brief Highest value of used() since construction. */
+        std::size_t high_water() const noexcept
+        {
+            return high_water_;
+        }
+
+        /** @brief Total bytes held in slabs. */
+        std::size_t capacity() const noexcept
+        {
+            std::size_t total{};
+            for (const slab& s : slabs_)
+                total += s.size;
+
+            return total;
+        }
+
+        /** @brief Number of slabs allocated so far. */
+        std::size_t slab_count() const noexcept
+        {
+            return slabs_.size();
+        }
+
+        /**
+         * @brief Gets the arena of the calling thread.
+         */
+        static frame_arena& local()
+        {
+            thread_local frame_arena arena;
+            return arena;
+        }
+
+    private:
+        struct slab
+        {
+            std::byte* data;
+            std::size_t size;
+            std::size_t alignment;
+        };
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override
+        {
+            for (;;)
+            {
+                if (current_ < slabs_.size())
+                {
+                    const slab& s{slabs_[current_]};
+                    // Aligns the address, not the offset: alignment may exceed the slab's own alignment.
+                    const std::uintptr_t base{reinterpret_cast<std::uintptr_t>(s.data)};
+                    const std::size_t aligned_offset{((base + offset_ + alignment - 1) & ~(std::uintptr_t{alignment} - 1)) - base};
+
+                    if (aligned_offset + bytes <= s.size)
+                    {
+                        used_ += aligned_offset + bytes - offset_;
+                        offset_ = aligned_offset + bytes;
+                        if (used_ > high_water_)
+                            high_water_ = used_;
+
+                        return s.data + aligned_offset;
+                    }
+
+                    used_ += s.size - offset_;
+                    ++current_;
+                    offset_ = 0;
+                    continue;
+                }
+
+                // A new slab starts aligned for the request, so it only needs room for bytes.
+                const std::size_t size{(bytes > slab_size_) ? bytes : slab_size_};
+                const std::size_t align{(alignment > slab_alignment) ? alignment : slab_alignment};
+                slabs_.push_back({static_cast<std::byte*>(::operator new(size, std::align_val_t{align})), size, align});
+            }
+        }
+
+        void do_deallocate(void* /*ptr*/, std::size_t /*bytes*/, std::size_t /*alignment*/) override
+        {
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+
+        std::vector<slab> slabs_;
+        std::size_t slab_size_;
+        std::size_t current_{};
+        std::size_t offset_{};
+        std::size_t used_{};
+        std::size_t high_water_{};
+    };
+
+    /**
+     * @brief RAII scope over the calling thread's frame_arena.
+     * Everything allocated from the arena during the scope is released when it ends. Scopes nest,
+     * so a filter whose get_frame runs inside another filter's get_frame on the same thread is safe.
+     */
+    class frame_arena_scope
+    {
+    public:
+        frame_arena_scope()
+            : arena_(frame_arena::local()), mark_(arena_.get_mark())
+        {
+        }
+
+        ~frame_arena_scope()
+        {
+            arena_.rewind(mark_);
+        }
+
+        frame_arena_scope(const frame_arena_scope&) = delete;
+        frame_arena_scope& operator=(const frame_arena_scope&) = delete;
+
+        frame_arena& arena() const noexcept
+        {
+            return arena_;
+        }
+
+    private:
+        frame_arena& arena_;
+        frame_arena::mark mark_;
+    };
+
+    /**
+     * @brief get_frame adapter that hands the thread's frame_arena to the filter callback.
+     * Usage: fi->get_frame = avs_helpers::arena_get_frame<my_get_frame>;
+     * where my_get_frame is AVS_VideoFrame* my_get_frame(AVS_FilterInfo* fi, int n, avs_helpers::frame_arena& arena).
+     * The arena is rewound when the callback returns.
+     */
+    template<AVS_VideoFrame* (*GetFrame)(AVS_FilterInfo*, int, frame_arena&)>
+    AVS_VideoFrame* AVSC_CC arena_get_frame(AVS_FilterInfo* fi, int n)
+    {
+        frame_arena_scope scope;
+        return GetFrame(fi, n, scope.arena());
+    }
+
     /**
      * @brief RAII wrapper for an AVS_Value.
      * Ensures g_avs_api->avs_release_value is called when the guard goes out of scope,
@@ -280,6 +739,199 @@ namespace avs_helpers
         bool owns_value_;
     };
 
+    /**
+     * @brief Lean RAII wrapper for an AVS_Value without a separate ownership flag.
+     * Ownership is encoded in the value itself: a void value owns nothing, any other value is released
+     * with avs_release_value on destruction. The object is exactly one AVS_Value, so it can be relocated
+     * with memcpy (e.g. by containers that support trivially relocatable types).
+     */
+    class avs_value_owner
+    {
+    public:
+        /**
+         * @brief Default constructor. Initializes to avs_void.
+         */
+        avs_value_owner() noexcept
+            : value_(avs_void)
+        {
+        }
+
+        /**
+         * @brief Constructs an owner taking ownership of the provided AVS_Value.
+         */
+        explicit avs_value_owner(AVS_Value val) noexcept
+            : value_(val)
+        {
+        }
+
+        ~avs_value_owner()
+        {
+            if (value_.type != 'v')
+                g_avs_api->avs_release_value(value_);
+        }
+
+        avs_value_owner(const avs_value_owner&) = delete;
+        avs_value_owner& operator=(const avs_value_owner&) = delete;
+
+        avs_value_owner(avs_value_owner&& other) noexcept
+            : value_(other.value_)
+        {
+            other.value_ = avs_void;
+        }
+
+        avs_value_owner& operator=(avs_value_owner&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset(other.value_);
+                other.value_ = avs_void;
+            }
+
+            return *this;
+        }
+
+        /**
+         * @brief Gets a copy of the managed AVS_Value. Does not affect ownership.
+         */
+        AVS_Value get() const noexcept
+        {
+            return value_;
+        }
+
+        /**
+         * @brief Releases ownership of the managed AVS_Value and returns it. The owner is left as avs_void.
+         */
+        AVS_Value release() noexcept
+        {
+            AVS_Value temp{value_};
+            value_ = avs_void;
+
+            return temp;
+        }
+
+        /**
+         * @brief Releases the current value (if any) and takes ownership of new_val.
+         */
+        void reset(AVS_Value new_val = avs_void) noexcept
+        {
+            if (value_.type != 'v')
+                g_avs_api->avs_release_value(value_);
+
+            value_ = new_val;
+        }
+
+    private:
+        AVS_Value value_;
+    };
+
+    static_assert(sizeof(avs_value_owner) == sizeof(AVS_Value));
+
+    /**
+     * @brief Fixed-capacity, stack-allocated array of owned AVS_Values, released in bulk on destruction.
+     * Intended for building argument lists for avs_invoke without per-element guards.
+     * @tparam N Maximum number of values.
+     */
+    template<std::size_t N>
+    class avs_value_array_guard
+    {
+    public:
+        avs_value_array_guard() noexcept = default;
+
+        ~avs_value_array_guard()
+        {
+            clear();
+        }
+
+        avs_value_array_guard(const avs_value_array_guard&) = delete;
+        avs_value_array_guard& operator=(const avs_value_array_guard&) = delete;
+
+        /**
+         * @brief Appends a value, taking ownership of it.
+         * @return false if the array is full (ownership is not taken in that case).
+         */
+        bool push_back(AVS_Value val) noexcept
+        {
+            if (size_ == N)
+                return false;
+
+            values_[size_++] = val;
+            return true;
+        }
+
+        /**
+         * @brief Releases all owned values and empties the array.
+         */
+        void clear() noexcept
+        {
+            for (std::size_t i{0}; i < size_; ++i)
+            {
+                if (values_[i].type != 'v')
+                    g_avs_api->avs_release_value(values_[i]);
+            }
+
+            size_ = 0;
+        }
+
+        /**
+         * @brief Gets an AVS_Value of array type referring to the stored values (e.g. args for avs_invoke).
+         * The stored values stay owned by the guard.
+         */
+        AVS_Value as_array() noexcept
+        {
+            return avs_new_value_array(values_.data(), static_cast<int>(size_));
+        }
+
+        const AVS_Value& operator[](std::size_t i) const noexcept
+        {
+            return values_[i];
+        }
+
+        std::size_t size() const noexcept
+        {
+            return size_;
+        }
+
+        AVS_Value* data() noexcept
+        {
+            return values_.data();
+        }
+
+    private:
+        std::array<AVS_Value, N> values_;
+        std::size_t size_{};
+    };
+
+    // --- Format Helpers ---
+
+    /**
+     * @brief Gets the planes of a format in storage order: Y, U, V, (A) for planar YUV(A), G, B, R, (A) for planar RGB(A).
+     * Packed and Y-only formats have a single plane, 0 (the default plane of the avs_get_*_p functions).
+     * @param vi The video info.
+     * @param planes Receives the plane ids.
+     * @return Number of planes.
+     */
+    inline int get_planes(const AVS_VideoInfo& vi, int (&planes)[4])
+    {
+        if (!(vi.pixel_type & AVS_CS_PLANAR) || g_avs_api->avs_is_y(&vi))
+        {
+            planes[0] = 0;
+            return 1;
+        }
+
+        const bool rgb{g_avs_api->avs_is_planar_rgb(&vi) || g_avs_api->avs_is_planar_rgba(&vi)};
+        planes[0] = (rgb) ? AVS_PLANAR_G : AVS_PLANAR_Y;
+        planes[1] = (rgb) ? AVS_PLANAR_B : AVS_PLANAR_U;
+        planes[2] = (rgb) ? AVS_PLANAR_R : AVS_PLANAR_V;
+
+        if (g_avs_api->avs_is_yuva(&vi) || g_avs_api->avs_is_planar_rgba(&vi))
+        {
+            planes[3] = AVS_PLANAR_A;
+            return 4;
+        }
+
+        return 3;
+    }
+
     // --- Argument Parsing Helper ---
 
     /**
@@ -457,3 +1109,7 @@ namespace avs_helpers
         return vec;
     }
 } // namespace avs_helpers
+
+#ifdef AVS_C_API_LOADER_HEADER_ONLY
+#include "avs_c_api_loader_impl.hpp"
+#endif
@@ -0,0 +1,91 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include "avs_c_api_loader.hpp"
+
+// AVS_HELPERS_KERNEL marks a helper kernel for function multiversioning.
+// With AVS_HELPERS_TARGET_CLONES defined (CMake option AVS_C_API_LOADER_TARGET_CLONES) and GCC >= 12 or
+// Clang >= 16 targeting x86-64 ELF, the kernel is compiled for x86-64 (baseline), x86-64-v2, x86-64-v3 and
+// x86-64-v4 and the best clone is selected once by an ifunc resolver at load time. Otherwise it expands to
+// nothing and the kernel is compiled for the target the plugin is built for.
+// Apply it to non-template functions only (Clang does not support target_clones on templates); call
+// templates through non-template wrappers.
+#if defined(AVS_HELPERS_TARGET_CLONES) && defined(__x86_64__) && defined(__ELF__) && \
+    ((defined(__clang__) && __clang_major__ >= 16) || (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 12))
+#define AVS_HELPERS_HAS_TARGET_CLONES 1
+#define AVS_HELPERS_KERNEL \
+    __attribute__((target_clones("default", "arch=x86-64-v2", "arch=x86-64-v3", "arch=x86-64-v4")))
+#else
+#define AVS_HELPERS_HAS_TARGET_CLONES 0
+#define AVS_HELPERS_KERNEL
+#endif
+
+namespace avs_helpers
+{
+    /**
+     * @brief x86-64 micro-architecture levels used for kernel dispatch.
+     */
+    enum class cpu_level
+    {
+        baseline, // x86-64 (SSE2)
+        v2,       // SSE3, SSSE3, SSE4.1, SSE4.2, POPCNT
+        v3,       // AVX, AVX2, FMA, F16C, MOVBE
+        v4,       // AVX-512 F/BW/DQ/VL
+    };
+
+    /**
+     * @brief Gets the highest x86-64 level allowed by the host, according to avs_get_cpu_flags.
+     * This honors SetMaxCPU and similar restrictions set in the script.
+     * @param env The AVS_ScriptEnvironment pointer.
+     * @return The level, or cpu_level::baseline if avs_get_cpu_flags is not available.
+     */
+    inline cpu_level host_cpu_level(AVS_ScriptEnvironment* env)
+    {
+        if (!g_avs_api->avs_get_cpu_flags)
+            return cpu_level::baseline;
+
+        const long flags{g_avs_api->avs_get_cpu_flags(env)};
+        const auto has{[flags](long mask) { return (flags & mask) == mask; }};
+
+        if (!has(AVS_CPUF_SSE3 | AVS_CPUF_SSSE3 | AVS_CPUF_SSE4_1 | AVS_CPUF_SSE4_2 | AVS_CPUF_POPCNT))
+            return cpu_level::baseline;
+        if (!has(AVS_CPUF_AVX | AVS_CPUF_AVX2 | AVS_CPUF_FMA3 | AVS_CPUF_F16C | AVS_CPUF_MOVBE))
+            return cpu_level::v2;
+        if (!has(AVS_CPUF_AVX512F | AVS_CPUF_AVX512BW | AVS_CPUF_AVX512DQ | AVS_CPUF_AVX512VL))
+            return cpu_level::v3;
+
+        return cpu_level::v4;
+    }
+
+    /**
+     * @brief Gets the level the target_clones resolver selects on this machine.
+     * @return The level, or cpu_level::baseline when AVS_HELPERS_KERNEL does not multiversion.
+     */
+    inline cpu_level target_clones_cpu_level()
+    {
+#if AVS_HELPERS_HAS_TARGET_CLONES
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("x86-64-v4"))
+            return cpu_level::v4;
+        if (__builtin_cpu_supports("x86-64-v3"))
+            return cpu_level::v3;
+        if (__builtin_cpu_supports("x86-64-v2"))
+            return cpu_level::v2;
+#endif
+        return cpu_level::baseline;
+    }
+
+    /**
+     * @brief Checks that the clones selected at load time do not use instructions the host disallows.
+     * The ifunc resolver only looks at the CPU, while AviSynth+ may restrict the instruction set (SetMaxCPU).
+     * Plugins should fall back to their own dispatch (or reject the call) when this returns false.
+     * @param env The AVS_ScriptEnvironment pointer.
+     * @return true if target_clones_cpu_level() <= host_cpu_level(env).
+     */
+    inline bool target_clones_allowed(AVS_ScriptEnvironment* env)
+    {
+        return target_clones_cpu_level() <= host_cpu_level(env);
+    }
+} // namespace avs_helpers
@@ -0,0 +1,184 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "avs_cpu_dispatch.hpp"
+#include "avs_frame_view.hpp"
+#include "avs_thread_pool.hpp"
+
+namespace avs_helpers
+{
+    namespace detail
+    {
+        // Floyd-Steinberg over pixels [x0, x1) of one row. Errors are integers in input units scaled by 16 (the weights
+        // 7, 3, 5 and 1 are applied without division), so the result does not depend on the order in which rows add
+        // to a shared error row. err_cur/err_next are offset by one so that x - 1 and x + 1 stay in range; err_cur is
+        // cleared as it is consumed. right carries the error of the previous pixel of the row.
+        template<typename D>
+        AVS_FORCEINLINE void diffuse_segment(D* d, const std::uint16_t* s, std::int32_t* err_cur, std::int32_t* err_next, int x0, int x1,
+            std::int32_t& right, int shift, std::int32_t max_out)
+        {
+            const std::int32_t half{1 << (shift - 1)};
+            std::int32_t e_right{right};
+
+            for (int x{x0}; x < x1; ++x)
+            {
+                const std::int32_t acc{err_cur[x] + e_right};
+                err_cur[x] = 0;
+
+                const std::int32_t v{s[x] + ((acc + 8) >> 4)};
+                const std::int32_t q{std::min(std::max((v + half) >> shift, 0), max_out)};
+                const std::int32_t e{v - (q << shift)};
+
+                d[x] = static_cast<D>(q);
+                err_next[x - 1] += 3 * e;
+                err_next[x] += 5 * e;
+                err_next[x + 1] += e;
+                e_right = 7 * e;
+            }
+
+            right = e_right;
+        }
+
+        AVS_HELPERS_KERNEL inline void diffuse_segment_u8(std::uint8_t* d, const std::uint16_t* s, std::int32_t* err_cur,
+            std::int32_t* err_next, int x0, int x1, std::int32_t& right, int shift, std::int32_t max_out)
+        {
+            diffuse_segment(d, s, err_cur, err_next, x0, x1, right, shift, max_out);
+        }
+
+        AVS_HELPERS_KERNEL inline void diffuse_segment_u16(std::uint16_t* d, const std::uint16_t* s, std::int32_t* err_cur,
+            std::int32_t* err_next, int x0, int x1, std::int32_t& right, int shift, std::int32_t max_out)
+        {
+            diffuse_segment(d, s, err_cur, err_next, x0, x1, right, shift, max_out);
+        }
+
+        // Rows are cut into blocks of block_width pixels. The last pixel of block j of row y needs the error that
+        // row y - 1 spreads down-left from the first pixel of block j + 1, so block j may start once row y - 1 has
+        // finished blocks 0..j + 1: a diagonal wavefront with a skew of two blocks per row. Rows run in order on the
+        // pool's threads, each waiting on the progress of the row above.
+        // Row y reads error row y % 2 and adds to error row (y + 1) % 2. Row y + 2 adds to the same row as y, but
+        // only at columns row y + 1 has already consumed (two blocks behind row y + 1, which is two behind row y).
+        template<typename D>
+        void error_diffuse(plane_view<D> dst, plane_view<const std::uint16_t> src, int shift, std::int32_t max_out, thread_pool* pool,
+            int block_width)
+        {
+            const int width{dst.width};
+            const int height{dst.height};
+            block_width = std::max(block_width, 4);
+            const int blocks{(width + block_width - 1) / block_width};
+
+            std::vector<std::int32_t> err(2 * static_cast<std::size_t>(width + 2));
+            const auto err_row{[&](int y) { return err.data() + (y & 1) * (width + 2) + 1; }};
+
+            const auto segment{[&](int y, int j, std::int32_t& right) {
+                D* d{dst.row(y)};
+                const std::uint16_t* s{src.row(y)};
+                const int x0{j * block_width};
+                const int x1{std::min(x0 + block_width, width)};
+
+                if constexpr (sizeof(D) == 1)
+                    diffuse_segment_u8(d, s, err_row(y), err_row(y + 1), x0, x1, right, shift, max_out);
+                else
+                    diffuse_segment_u16(d, s, err_row(y), err_row(y + 1), x0, x1, right, shift, max_out);
+            }};
+
+            if (!pool || pool->worker_count() == 0 || height < 2 || blocks < 3)
+            {
+                for (int y{0}; y < height; ++y)
+                {
+                    std::int32_t right{};
+                    for (int j{0}; j < blocks; ++j)
+                        segment(y, j, right);
+                }
+                return;
+            }
+
+            // Completed blocks of each row.
+            const auto progress{std::make_unique<std::atomic<int>[]>(height)};
+
+            pool->parallel_for(height, [&](int y) {
+                std::int32_t right{};
+                for (int j{0}; j < blocks; ++j)
+                {
+                    if (y > 0)
+                    {
+                        const int needed{std::min(j + 2, blocks)};
+                        for (int done{progress[y - 1].load(std::memory_order_acquire)}; done < needed;
+                             done = progress[y - 1].load(std::memory_order_acquire))
+                            progress[y - 1].wait(done, std::memory_order_acquire);
+                    }
+
+                    segment(y, j, right);
+
+                    progress[y].store(j + 1, std::memory_order_release);
+                    progress[y].notify_all();
+                }
+            });
+        }
+    } // namespace detail
+
+    /**
+     * @brief Reduces the bit depth of a plane with Floyd-Steinberg error diffusion.
+     * Samples are mapped by shift (as ConvertBits does for integer formats) with the rounding error spread to the
+     * neighbours in integer arithmetic. With a pool, rows run as a diagonal wavefront of block_width-pixel segments
+     * on the pool's threads; the output is bit-identical to the single-threaded one (pool nullptr).
+     * @param dst Destination plane, 8-bit.
+     * @param src Source plane with bits_in (9..16) bits per sample and the size of dst.
+     * @return false if bits_in is out of range.
+     */
+    inline bool error_diffuse_plane(plane_view<std::uint8_t> dst, plane_view<const std::uint16_t> src, int bits_in,
+        thread_pool* pool = nullptr, int block_width = 128)
+    {
+        if (bits_in <= 8 || bits_in > 16)
+            return false;
+
+        detail::error_diffuse(dst, src, bits_in - 8, 255, pool, block_width);
+
+        return true;
+    }
+
+    /**
+     * @brief Reduces the bit depth of a plane with Floyd-Steinberg error diffusion (e.g. 16 to 10 bits).
+     * @param dst Destination plane with bits_out (8..15) bits per sample.
+     * @return false if bits_out is not below bits_in or out of range.
+     */
+    inline bool error_diffuse_plane(plane_view<std::uint16_t> dst, plane_view<const std::uint16_t> src, int bits_in, int bits_out,
+        thread_pool* pool = nullptr, int block_width = 128)
+    {
+        if (bits_out < 8 || bits_out >= bits_in || bits_in > 16)
+            return false;
+
+        detail::error_diffuse(dst, src, bits_in - bits_out, (1 << bits_out) - 1, pool, block_width);
+
+        return true;
+    }
+
+    /**
+     * @brief Reduces the bit depth of all planes of a frame with error diffusion (see error_diffuse_plane).
+     * @param dst Writable frame of the same format and size with fewer bits per sample (8-bit or high bit depth).
+     * @param src Frame with 9..16 bits per sample.
+     * @return false if the bit depths are not supported.
+     */
+    inline bool error_diffuse(const frame_view& dst, const frame_view& src, thread_pool* pool = nullptr)
+    {
+        if (dst.num_planes != src.num_planes || src.bits > 16)
+            return false;
+
+        for (int i{0}; i < dst.num_planes; ++i)
+        {
+            const bool ok{(dst.bits == 8) ? error_diffuse_plane(dst.write<std::uint8_t>(i), src.read<std::uint16_t>(i), src.bits, pool)
+                                          : error_diffuse_plane(dst.write<std::uint16_t>(i), src.read<std::uint16_t>(i), src.bits, dst.bits, pool)};
+            if (!ok)
+                return false;
+        }
+
+        return true;
+    }
+} // namespace avs_helpers
@@ -0,0 +1,403 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "avs_c_api_loader.hpp"
+
+namespace avs_helpers
+{
+    /**
+     * @brief Pool of warm script environments for hosts that evaluate many short scripts.
+     * Each environment is created through avisynth_c_api_loader::create_script_environment, has the configured
+     * plugins loaded and globals set, and is handed out with acquire(). When a lease ends the environment goes
+     * back to the pool, or is replaced by a fresh one if it was discarded or reached max_uses (variables set by
+     * a script persist in its environment, so max_uses bounds how far that state can leak between scripts).
+     * Thread-safe.
+     */
+    class script_env_pool
+    {
+    public:
+        struct config
+        {
+            int interface_version{10};
+            int bugfix_version{0};
+            /** Copied by open(); need not outlive the call. */
+            std::span<const std::string_view> required_functions;
+            /** Number of environments kept warm. */
+            std::size_t size{2};
+            /** Uses before an environment is replaced; 0 for unlimited. */
+            std::uint32_t max_uses{0};
+            /** Run AutoloadPlugins() on creation, so the first script does not pay for it. */
+            bool autoload_plugins{true};
+            /** Plugins loaded with LoadPlugin on creation. */
+            std::vector<std::string> plugins;
+            /** String globals set with avs_set_global_var on creation. */
+            std::vector<std::pair<std::string, std::string>> string_globals;
+            /** Optional extra preparation (e.g. non-string globals). Return false to reject the environment. */
+            std::function<bool(AVS_ScriptEnvironment*)> prepare;
+        };
+
+        struct statistics
+        {
+            std::uint64_t acquisitions{};
+            std::uint64_t reuses{};       // Acquisitions served by a previously used environment.
+            std::uint64_t created{};      // Environments created (initial and replacements).
+            std::uint64_t recycled{};     // Environments replaced because of max_uses or discard().
+            std::uint64_t acquire_wait_ns_total{};
+            std::uint64_t acquire_wait_ns_max{};
+        };
+
+        /**
+         * @brief RAII lease of one environment. Returns it to the pool on destruction.
+         */
+        class lease
+        {
+        public:
+            lease() = default;
+
+            ~lease()
+            {
+                reset();
+            }
+
+            lease(const lease&) = delete;
+            lease& operator=(const lease&) = delete;
+
+            lease(lease&& other) noexcept
+                : pool_(std::exchange(other.pool_, nullptr)), slot_(other.slot_), discard_(other.discard_)
+            {
+            }
+
+            lease& operator=(lease&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    pool_ = std::exchange(other.pool_, nullptr);
+                    slot_ = other.slot_;
+                    discard_ = other.discard_;
+                }
+
+                return *this;
+            }
+
+            AVS_ScriptEnvironment* env() const noexcept
+            {
+                return (pool_) ? pool_->slots_[slot_].env : nullptr;
+            }
+
+            explicit operator bool() const noexcept
+            {
+                return env() != nullptr;
+            }
+
+            /**
+             * @brief Requests that the environment is replaced instead of reused (e.g. after an error).
+             */
+            void discard() noexcept
+            {
+                discard_ = true;
+            }
+
+            /**
+             * @brief Returns the environment to the pool now.
+             */
+            void reset()
+            {
+                if (pool_)
+                    std::exchange(pool_, nullptr)->release(slot_, discard_);
+            }
+
+        private:
+            friend class script_env_pool;
+
+            lease(script_env_pool* pool, std::size_t slot)
+                : pool_(pool), slot_(slot)
+            {
+            }
+
+            script_env_pool* pool_{};
+            std::size_t slot_{};
+            bool discard_{};
+        };
+
+        script_env_pool() = default;
+
+        ~script_env_pool()
+        {
+            close();
+        }
+
+        script_env_pool(const script_env_pool&) = delete;
+        script_env_pool& operator=(const script_env_pool&) = delete;
+
+        /**
+         * @brief Creates and prepares cfg.size environments.
+         * @return false on error (see last_error()). Environments created before the error are kept.
+         */
+        bool open(config cfg)
+        {
+            std::lock_guard lock{mutex_};
+
+            cfg_ = std::move(cfg);
+            required_names_.assign(cfg_.required_functions.begin(), cfg_.required_functions.end());
+            required_views_.assign(required_names_.begin(), required_names_.end());
+            cfg_.required_functions = required_views_;
+            slots_.resize((cfg_.size) ? cfg_.size : 1);
+
+            for (slot& s : slots_)
+            {
+                if (s.env)
+                    continue;
+
+                std::string error;
+                s = {create(error)};
+                if (!s.env)
+                {
+                    last_error_ = std::move(error);
+                    return false;
+                }
+                ++stats_.created;
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Gets a warm environment, waiting until one is free.
+         * A free slot whose environment failed to create earlier is retried (outside the pool's lock).
+         * @return The lease; empty if the pool is not open or the environment could not be created (see last_error()).
+         */
+        lease acquire()
+        {
+            const auto start{std::chrono::steady_clock::now()};
+            std::unique_lock lock{mutex_};
+
+            std::size_t index{};
+            available_.wait(lock, [&] {
+                if (slots_.empty())
+                    return true;
+                for (index = 0; index < slots_.size(); ++index)
+                {
+                    if (!slots_[index].in_use)
+                        return true;
+                }
+                return false;
+            });
+
+            if (slots_.empty())
+                return {};
+
+            slots_[index].in_use = true;
+
+            if (!slots_[index].env)
+            {
+                lock.unlock();
+                std::string error;
+                AVS_ScriptEnvironment* const env{create(error)};
+                lock.lock();
+
+                if (index >= slots_.size())
+                {
+                    // Closed meanwhile.
+                    if (env)
+                        delete_environment(env);
+                    return {};
+                }
+
+                slot& s{slots_[index]};
+                if (!env)
+                {
+                    s.in_use = false;
+                    last_error_ = std::move(error);
+                    available_.notify_one();
+                    return {};
+                }
+                s = {env, 0, true};
+                ++stats_.created;
+            }
+
+            slot& s{slots_[index]};
+            if (s.uses++)
+                ++stats_.reuses;
+            ++stats_.acquisitions;
+
+            const std::uint64_t waited{static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count())};
+            stats_.acquire_wait_ns_total += waited;
+            if (waited > stats_.acquire_wait_ns_max)
+                stats_.acquire_wait_ns_max = waited;
+
+            return lease{this, index};
+        }
+
+        /**
+         * @brief Deletes all environments. Leases must have ended.
+         */
+        void close()
+        {
+            std::lock_guard lock{mutex_};
+            std::lock_guard loader_lock{loader_mutex_};
+
+            // Deleting the last environment unloads the library and clears g_avs_api.
+            const avs_delete_script_environment_func delete_env{(g_avs_api) ? g_avs_api->avs_delete_script_environment : nullptr};
+            for (slot& s : slots_)
+            {
+                if (s.env && delete_env)
+                    delete_env(s.env);
+            }
+
+            slots_.clear();
+            available_.notify_all();
+        }
+
+        statistics stats() const
+        {
+            std::lock_guard lock{mutex_};
+            return stats_;
+        }
+
+        /**
+         * @brief Gets the last error message. Empty if there was no error.
+         */
+        std::string last_error() const
+        {
+            std::lock_guard lock{mutex_};
+            return last_error_;
+        }
+
+    private:
+        struct slot
+        {
+            AVS_ScriptEnvironment* env{};
+            std::uint32_t uses{};
+            bool in_use{};
+        };
+
+        // Creates and prepares an environment. Only reads cfg_ (which changes only in open()), so it may run
+        // without mutex_. Returns nullptr and sets error on failure.
+        AVS_ScriptEnvironment* create(std::string& error)
+        {
+            AVS_ScriptEnvironment* env;
+            {
+                // The loader's reference count and error message are not thread-safe.
+                std::lock_guard loader_lock{loader_mutex_};
+                env = avisynth_c_api_loader::create_script_environment(cfg_.interface_version, cfg_.bugfix_version, cfg_.required_functions);
+                if (!env)
+                {
+                    error = avisynth_c_api_loader::get_last_error();
+                    return nullptr;
+                }
+            }
+
+            const auto invoke_ok{[&](const char* name, AVS_Value args) {
+                avs_value_owner result{g_avs_api->avs_invoke(env, name, args, nullptr)};
+                if (avs_is_error(result.get()))
+                {
+                    error = avs_as_error(result.get());
+                    return false;
+                }
+                return true;
+            }};
+
+            bool ok{!cfg_.autoload_plugins || invoke_ok("AutoloadPlugins", avs_new_value_array(nullptr, 0))};
+
+            for (std::size_t i{0}; ok && i < cfg_.plugins.size(); ++i)
+                ok = invoke_ok("LoadPlugin", avs_new_value_string(cfg_.plugins[i].c_str()));
+
+            for (std::size_t i{0}; ok && i < cfg_.string_globals.size(); ++i)
+            {
+                const auto& [name, value]{cfg_.string_globals[i]};
+                const char* saved_name{g_avs_api->avs_save_string(env, name.c_str(), static_cast<int>(name.size()))};
+                const char* saved_value{g_avs_api->avs_save_string(env, value.c_str(), static_cast<int>(value.size()))};
+                ok = g_avs_api->avs_set_global_var(env, saved_name, avs_new_value_string(saved_value)) == 0;
+                if (!ok)
+                    error = "script_env_pool: avs_set_global_var failed for " + name;
+            }
+
+            if (ok && cfg_.prepare && !cfg_.prepare(env))
+            {
+                ok = false;
+                error = "script_env_pool: prepare callback rejected the environment.";
+            }
+
+            if (!ok)
+            {
+                delete_environment(env);
+                return nullptr;
+            }
+
+            return env;
+        }
+
+        // Deleting the last environment unloads the library, so deletions go through the loader lock too.
+        void delete_environment(AVS_ScriptEnvironment* env)
+        {
+            std::lock_guard loader_lock{loader_mutex_};
+            g_avs_api->avs_delete_script_environment(env);
+        }
+
+        void release(std::size_t index, bool discard)
+        {
+            std::unique_lock lock{mutex_};
+
+            if (index >= slots_.size())
+                return;
+
+            if (discard || (cfg_.max_uses && slots_[index].uses >= cfg_.max_uses))
+            {
+                // The slot stays in use while its replacement is created outside the lock. The replacement is
+                // created before the old environment is deleted, so the library stays loaded. If it fails, the slot
+                // is left empty and acquire() retries.
+                AVS_ScriptEnvironment* const old_env{slots_[index].env};
+                lock.unlock();
+                std::string error;
+                AVS_ScriptEnvironment* const env{create(error)};
+                delete_environment(old_env);
+                lock.lock();
+
+                if (index >= slots_.size())
+                {
+                    if (env)
+                        delete_environment(env);
+                    return;
+                }
+
+                slots_[index] = {env, 0, true};
+                ++stats_.recycled;
+                if (env)
+                    ++stats_.created;
+                else
+                    last_error_ = std::move(error);
+            }
+
+            slots_[index].in_use = false;
+            available_.notify_one();
+        }
+
+        config cfg_;
+        // Owned copy of cfg_.required_functions (cfg_ points at required_views_).
+        std::vector<std::string> required_names_;
+        std::vector<std::string_view> required_views_;
+        std::vector<slot> slots_;
+        statistics stats_;
+        std::string last_error_;
+        mutable std::mutex mutex_;
+        // Serializes the loader calls (creation and deletion of environments), which run outside mutex_ so that
+        // waiters are not blocked while an environment is prepared. Taken after mutex_ when both are held.
+        std::mutex loader_mutex_;
+        std::condition_variable available_;
+    };
+} // namespace avs_helpers
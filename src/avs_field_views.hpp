@@ -0,0 +1,144 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <cstdint>
+
+#include "avs_frame_view.hpp"
+
+namespace avs_helpers
+{
+    enum class field
+    {
+        top,
+        bottom
+    };
+
+    /**
+     * @brief Gets the field of a field-based clip, or the first field of frame n of a frame-based clip
+     * (avs_get_parity: true is top field / top field first).
+     */
+    inline field clip_field(AVS_Clip* clip, int n)
+    {
+        return (g_avs_api->avs_get_parity(clip, n)) ? field::top : field::bottom;
+    }
+
+    /**
+     * @brief Gets the source field of field number field_n when the frames of a frame-based clip are split into
+     * fields in temporal order (field_n / 2 is the source frame; the first field of it follows its parity).
+     */
+    inline field separated_field(AVS_Clip* clip, int field_n)
+    {
+        const field first{clip_field(clip, field_n >> 1)};
+        return (field_n & 1) ? ((first == field::top) ? field::bottom : field::top) : first;
+    }
+
+    namespace detail
+    {
+        // First stored row of a field of a plane with height rows. Packed RGB is stored bottom-up, so its top
+        // (displayed) line is the last stored row.
+        constexpr int field_first_row(field f, int height, bool bottom_up) noexcept
+        {
+            const int line{(f == field::bottom) ? 1 : 0};
+            return (bottom_up) ? (height - 1 - line) & 1 : line;
+        }
+    } // namespace detail
+
+    /**
+     * @brief Gets the view of one field of a plane: every other row, as doubled pitch and an offset start.
+     * Nothing is copied, so a writable field view writes straight into the alternating rows of the frame.
+     * @param bottom_up true for packed RGB, whose rows are stored bottom-up.
+     */
+    template<typename T>
+    plane_view<T> field_of(plane_view<T> plane, field f, bool bottom_up = false) noexcept
+    {
+        const int first{detail::field_first_row(f, plane.height, bottom_up)};
+        return {plane.row(first), plane.pitch * 2, plane.width, (plane.height - first + 1) >> 1};
+    }
+
+    /**
+     * @brief Gets a read-only view of one field of a plane of a frame (see field_of).
+     * @param index Plane index in frame_view::planes.
+     */
+    template<typename T>
+    plane_view<const T> read_field(const frame_view& frame, int index, field f)
+    {
+        return field_of(frame.read<T>(index), f, frame.bottom_up);
+    }
+
+    /**
+     * @brief Gets a writable view of one field of a plane of a frame (see field_of). The frame must be writable.
+     * @param index Plane index in frame_view::planes.
+     */
+    template<typename T>
+    plane_view<T> write_field(const frame_view& frame, int index, field f)
+    {
+        return field_of(frame.write<T>(index), f, frame.bottom_up);
+    }
+
+    /**
+     * @brief Gets one field of a frame as a new frame that shares the source buffer (avs_subframe_planar(_a),
+     * avs_subframe for packed formats), which get_frame can return directly, as SeparateFields does.
+     * The returned frame is read-only; its height is vi.height / 2.
+     * @param vi Video info of the (frame-based) source.
+     * @return The field, or an empty pointer if vi.height is not a multiple of 2 << vertical chroma subsampling.
+     */
+    inline avs_video_frame_ptr separate_field(AVS_ScriptEnvironment* env, AVS_VideoFrame* frame, const AVS_VideoInfo& vi, field f)
+    {
+        int planes[4];
+        const int num_planes{get_planes(vi, planes)};
+        const bool bottom_up{(vi.pixel_type & AVS_CS_BGR) && !(vi.pixel_type & AVS_CS_PLANAR)};
+        const int sub_h{(num_planes > 1 && planes[1] == AVS_PLANAR_U) ? g_avs_api->avs_get_plane_height_subsampling(&vi, AVS_PLANAR_U) : 0};
+
+        if (vi.height % (2 << sub_h))
+            return {};
+
+        const auto offset = [&](int plane) {
+            const int pitch{g_avs_api->avs_get_pitch_p(frame, plane)};
+            return detail::field_first_row(f, g_avs_api->avs_get_height_p(frame, plane), bottom_up) * pitch;
+        };
+
+        const int pitch{g_avs_api->avs_get_pitch_p(frame, planes[0])};
+        const int row_size{g_avs_api->avs_get_row_size_p(frame, planes[0])};
+        const int height{vi.height >> 1};
+
+        if (num_planes == 1)
+            return avs_video_frame_ptr{g_avs_api->avs_subframe(env, frame, offset(planes[0]), pitch * 2, row_size, height)};
+
+        // The U/V offsets are relative to their own planes; chroma pitch is shared by U and V.
+        const int pitch_uv{g_avs_api->avs_get_pitch_p(frame, planes[1])};
+        if (num_planes == 3)
+            return avs_video_frame_ptr{g_avs_api->avs_subframe_planar(
+                env, frame, offset(planes[0]), pitch * 2, row_size, height, offset(planes[1]), offset(planes[2]), pitch_uv * 2)};
+
+        return avs_video_frame_ptr{g_avs_api->avs_subframe_planar_a(env, frame, offset(planes[0]), pitch * 2, row_size, height,
+            offset(planes[1]), offset(planes[2]), pitch_uv * 2, offset(planes[3]))};
+    }
+
+    /**
+     * @brief Copies a field frame into the alternating rows of a frame, one field at a time (the inverse of
+     * separate_field). Processing a field in place through write_field avoids even this copy.
+     * @param dst Writable frame of the same format as field_frame, with twice its height.
+     */
+    inline void weave_field(AVS_ScriptEnvironment* env, const frame_view& dst, const frame_view& field_frame, field f)
+    {
+        for (int i{0}; i < dst.num_planes; ++i)
+        {
+            const plane_view<std::uint8_t> d{write_field<std::uint8_t>(dst, i, f)};
+            const plane_view<const std::uint8_t> s{field_frame.read<std::uint8_t>(i)};
+
+            g_avs_api->avs_bit_blt(env, d.data, static_cast<int>(d.pitch), s.data, static_cast<int>(s.pitch), s.width, s.height);
+        }
+    }
+
+    /**
+     * @brief Weaves two field frames into a frame.
+     * @param dst Writable frame of the fields' format with twice their height.
+     */
+    inline void weave_fields(AVS_ScriptEnvironment* env, const frame_view& dst, const frame_view& top, const frame_view& bottom)
+    {
+        weave_field(env, dst, top, field::top);
+        weave_field(env, dst, bottom, field::bottom);
+    }
+} // namespace avs_helpers
@@ -0,0 +1,135 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "avs_c_api_loader.hpp"
+
+namespace avs_helpers
+{
+    /**
+     * @brief Non-owning view of one plane: data pointer, pitch in bytes and size in samples.
+     * @tparam T Sample type (std::uint8_t, std::uint16_t or float; const-qualified for read-only views).
+     */
+    template<typename T>
+    struct plane_view
+    {
+        using byte_type = std::conditional_t<std::is_const_v<T>, const std::uint8_t, std::uint8_t>;
+
+        T* data{};
+        std::ptrdiff_t pitch{};
+        int width{};
+        int height{};
+
+        T* row(int y) const noexcept
+        {
+            return reinterpret_cast<T*>(reinterpret_cast<byte_type*>(data) + y * pitch);
+        }
+
+        /**
+         * @brief Gets the view of rows [y, y + rows).
+         */
+        plane_view rows(int y, int rows) const noexcept
+        {
+            return {row(y), pitch, width, rows};
+        }
+
+        /**
+         * @brief Gets the view with the rows in reverse order (e.g. packed RGB, which is stored bottom-up, in display order).
+         */
+        plane_view flipped() const noexcept
+        {
+            return {row(height - 1), -pitch, width, height};
+        }
+
+        /**
+         * @brief Gets a read-only view of the same plane.
+         */
+        operator plane_view<const T>() const noexcept
+            requires(!std::is_const_v<T>)
+        {
+            return {data, pitch, width, height};
+        }
+    };
+
+    /**
+     * @brief Gets a read-only view of a plane of a frame.
+     * @param plane Plane id (e.g. AVS_PLANAR_Y, or 0 for packed formats).
+     */
+    template<typename T>
+    plane_view<const T> read_plane(const AVS_VideoFrame* frame, int plane)
+    {
+        return {reinterpret_cast<const T*>(g_avs_api->avs_get_read_ptr_p(frame, plane)), g_avs_api->avs_get_pitch_p(frame, plane),
+            g_avs_api->avs_get_row_size_p(frame, plane) / static_cast<int>(sizeof(T)), g_avs_api->avs_get_height_p(frame, plane)};
+    }
+
+    /**
+     * @brief Gets a writable view of a plane of a frame. The frame must be writable.
+     * @param plane Plane id (e.g. AVS_PLANAR_Y, or 0 for packed formats).
+     */
+    template<typename T>
+    plane_view<T> write_plane(AVS_VideoFrame* frame, int plane)
+    {
+        return {reinterpret_cast<T*>(g_avs_api->avs_get_write_ptr_p(frame, plane)), g_avs_api->avs_get_pitch_p(frame, plane),
+            g_avs_api->avs_get_row_size_p(frame, plane) / static_cast<int>(sizeof(T)), g_avs_api->avs_get_height_p(frame, plane)};
+    }
+
+    /**
+     * @brief Allocates an uninitialized scratch plane from a frame_arena, with rows aligned to 64 bytes.
+     * The plane is valid until the arena is rewound past it (e.g. until the end of the frame_arena_scope).
+     */
+    template<typename T>
+    plane_view<T> arena_plane(frame_arena& arena, int width, int height)
+    {
+        const std::ptrdiff_t pitch{(static_cast<std::ptrdiff_t>(width) * static_cast<std::ptrdiff_t>(sizeof(T)) + 63) & ~std::ptrdiff_t{63}};
+        return {static_cast<T*>(arena.allocate(static_cast<std::size_t>(pitch) * static_cast<std::size_t>(height), 64)), pitch, width, height};
+    }
+
+    /**
+     * @brief Planes of a frame in storage order (see get_planes), with their subsampling.
+     */
+    struct frame_view
+    {
+        AVS_VideoFrame* frame{};
+        int planes[4]{};
+        int num_planes{};
+        /** log2 horizontal/vertical subsampling of each plane relative to the first. */
+        int sub_w[4]{};
+        int sub_h[4]{};
+        int bits{8};
+        /** Packed RGB: rows are stored bottom-up. */
+        bool bottom_up{};
+
+        frame_view() = default;
+
+        frame_view(AVS_VideoFrame* f, const AVS_VideoInfo& vi)
+            : frame(f), num_planes(get_planes(vi, planes)), bits(g_avs_api->avs_bits_per_component(&vi)),
+              bottom_up((vi.pixel_type & AVS_CS_BGR) && !(vi.pixel_type & AVS_CS_PLANAR))
+        {
+            for (int i{0}; i < num_planes; ++i)
+            {
+                if (planes[i] == AVS_PLANAR_U || planes[i] == AVS_PLANAR_V)
+                {
+                    sub_w[i] = g_avs_api->avs_get_plane_width_subsampling(&vi, planes[i]);
+                    sub_h[i] = g_avs_api->avs_get_plane_height_subsampling(&vi, planes[i]);
+                }
+            }
+        }
+
+        template<typename T>
+        plane_view<const T> read(int index) const
+        {
+            return read_plane<T>(frame, planes[index]);
+        }
+
+        template<typename T>
+        plane_view<T> write(int index) const
+        {
+            return write_plane<T>(frame, planes[index]);
+        }
+    };
+} // namespace avs_helpers
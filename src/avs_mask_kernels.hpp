@@ -0,0 +1,399 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "avs_cpu_dispatch.hpp"
+#include "avs_frame_view.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define AVS_HELPERS_MASK_SSE2 1
+#else
+#define AVS_HELPERS_MASK_SSE2 0
+#endif
+
+namespace avs_helpers
+{
+    namespace detail
+    {
+        // Mask value for output sample x of a plane subsampled by (SW, SH): the rounded mean of the
+        // (1 << SW) x (1 << SH) block of the luma-resolution mask, read straight from the mask rows.
+        template<typename T, int SW, int SH>
+        AVS_FORCEINLINE auto mask_block_mean(const T* const (&mask_rows)[1 << SH], int x)
+        {
+            constexpr int count{1 << (SW + SH)};
+
+            if constexpr (std::is_same_v<T, float>)
+            {
+                float sum{};
+                for (int k{0}; k < (1 << SH); ++k)
+                {
+                    for (int j{0}; j < (1 << SW); ++j)
+                        sum += mask_rows[k][(x << SW) + j];
+                }
+                return sum * (1.0f / count);
+            }
+            else
+            {
+                std::uint32_t sum{};
+                for (int k{0}; k < (1 << SH); ++k)
+                {
+                    for (int j{0}; j < (1 << SW); ++j)
+                        sum += mask_rows[k][(x << SW) + j];
+                }
+                return (sum + count / 2) >> (SW + SH);
+            }
+        }
+
+#if AVS_HELPERS_MASK_SSE2
+        // Sums adjacent mask bytes of 16 bytes into 8 16-bit lanes.
+        AVS_FORCEINLINE __m128i mask_pair_sums(const std::uint8_t* p)
+        {
+            const __m128i v{_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))};
+            return _mm_add_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00ff)), _mm_srli_epi16(v, 8));
+        }
+
+        // mask_block_mean of the 8 output samples from x, in 16-bit lanes.
+        template<int SW, int SH>
+        AVS_FORCEINLINE __m128i mask_block_means_u8_sse2(const std::uint8_t* const (&mask_rows)[1 << SH], int x)
+        {
+            const __m128i zero{_mm_setzero_si128()};
+
+            __m128i sum{zero};
+            for (int k{0}; k < (1 << SH); ++k)
+            {
+                const std::uint8_t* m{mask_rows[k] + (x << SW)};
+                if constexpr (SW == 0)
+                    sum = _mm_add_epi16(sum, _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(m)), zero));
+                else if constexpr (SW == 1)
+                    sum = _mm_add_epi16(sum, mask_pair_sums(m));
+                else
+                {
+                    // Pairs of pair sums: 32-bit sums of 4 bytes, packed back to 16 bits.
+                    const __m128i lo{_mm_madd_epi16(mask_pair_sums(m), _mm_set1_epi16(1))};
+                    const __m128i hi{_mm_madd_epi16(mask_pair_sums(m + 16), _mm_set1_epi16(1))};
+                    sum = _mm_add_epi16(sum, _mm_packs_epi32(lo, hi));
+                }
+            }
+
+            return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16((1 << (SW + SH)) >> 1)), SW + SH);
+        }
+
+        // Packs two vectors of 32-bit values 0..65535 into unsigned 16-bit lanes (SSE2 has only the signed pack).
+        AVS_FORCEINLINE __m128i mask_pack_u32(__m128i lo, __m128i hi)
+        {
+            const __m128i bias{_mm_set1_epi32(32768)};
+            return _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(lo, bias), _mm_sub_epi32(hi, bias)), _mm_set1_epi16(-32768));
+        }
+
+        // Full 32-bit products of the unsigned 16-bit lanes of a and b: lanes 0..3 in lo, 4..7 in hi.
+        AVS_FORCEINLINE void mask_mul_u16(__m128i a, __m128i b, __m128i& lo, __m128i& hi)
+        {
+            const __m128i l{_mm_mullo_epi16(a, b)};
+            const __m128i h{_mm_mulhi_epu16(a, b)};
+            lo = _mm_unpacklo_epi16(l, h);
+            hi = _mm_unpackhi_epi16(l, h);
+        }
+
+        // mask_block_mean of the 8 output samples from x, in 16-bit lanes.
+        template<int SW, int SH>
+        AVS_FORCEINLINE __m128i mask_block_means_u16_sse2(const std::uint16_t* const (&rows)[1 << SH], int x)
+        {
+            if constexpr (SW + SH == 0)
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[0] + x));
+            else
+            {
+                const auto load{[](const std::uint16_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }};
+                // Sums of adjacent samples in 32-bit lanes.
+                const auto pair_sums{[&](const std::uint16_t* p) {
+                    const __m128i v{load(p)};
+                    return _mm_add_epi32(_mm_and_si128(v, _mm_set1_epi32(0xffff)), _mm_srli_epi32(v, 16));
+                }};
+                const auto quad_sums{[&](const std::uint16_t* p) {
+                    const __m128 a{_mm_castsi128_ps(pair_sums(p))};
+                    const __m128 b{_mm_castsi128_ps(pair_sums(p + 8))};
+                    return _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))),
+                        _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))));
+                }};
+
+                __m128i lo{_mm_setzero_si128()};
+                __m128i hi{_mm_setzero_si128()};
+                for (int k{0}; k < (1 << SH); ++k)
+                {
+                    const std::uint16_t* m{rows[k] + (x << SW)};
+                    if constexpr (SW == 0)
+                    {
+                        const __m128i v{load(m)};
+                        lo = _mm_add_epi32(lo, _mm_unpacklo_epi16(v, _mm_setzero_si128()));
+                        hi = _mm_add_epi32(hi, _mm_unpackhi_epi16(v, _mm_setzero_si128()));
+                    }
+                    else if constexpr (SW == 1)
+                    {
+                        lo = _mm_add_epi32(lo, pair_sums(m));
+                        hi = _mm_add_epi32(hi, pair_sums(m + 8));
+                    }
+                    else
+                    {
+                        lo = _mm_add_epi32(lo, quad_sums(m));
+                        hi = _mm_add_epi32(hi, quad_sums(m + 16));
+                    }
+                }
+
+                const __m128i round{_mm_set1_epi32((1 << (SW + SH)) >> 1)};
+                return mask_pack_u32(_mm_srli_epi32(_mm_add_epi32(lo, round), SW + SH), _mm_srli_epi32(_mm_add_epi32(hi, round), SW + SH));
+            }
+        }
+
+        // mask_block_mean of the 4 output samples from x, summed in the same order as the scalar code.
+        template<int SW, int SH>
+        AVS_FORCEINLINE __m128 mask_block_means_f32_sse2(const float* const (&rows)[1 << SH], int x)
+        {
+            __m128 sum{_mm_setzero_ps()};
+            for (int k{0}; k < (1 << SH); ++k)
+            {
+                const float* m{rows[k] + (x << SW)};
+                if constexpr (SW == 0)
+                    sum = _mm_add_ps(sum, _mm_loadu_ps(m));
+                else if constexpr (SW == 1)
+                {
+                    const __m128 a{_mm_loadu_ps(m)};
+                    const __m128 b{_mm_loadu_ps(m + 4)};
+                    sum = _mm_add_ps(sum, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+                    sum = _mm_add_ps(sum, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+                }
+                else
+                {
+                    __m128 r0{_mm_loadu_ps(m)};
+                    __m128 r1{_mm_loadu_ps(m + 4)};
+                    __m128 r2{_mm_loadu_ps(m + 8)};
+                    __m128 r3{_mm_loadu_ps(m + 12)};
+                    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                    sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(sum, r0), r1), r2), r3);
+                }
+            }
+
+            if constexpr (SW + SH == 0)
+                return sum;
+            else
+                return _mm_mul_ps(sum, _mm_set1_ps(1.0f / (1 << (SW + SH))));
+        }
+
+        // 8-bit masked merge of 8 samples per step; returns the first sample not processed.
+        // a * (256 - w) + b * w + 128 <= 65408, so the blend stays in unsigned 16-bit lanes.
+        template<int SW, int SH>
+        AVS_FORCEINLINE int masked_merge_row_u8_sse2(
+            std::uint8_t* d, const std::uint8_t* pa, const std::uint8_t* pb, const std::uint8_t* const (&mask_rows)[1 << SH], int width)
+        {
+            const __m128i zero{_mm_setzero_si128()};
+            const __m128i round_blend{_mm_set1_epi16(128)};
+            const __m128i full{_mm_set1_epi16(256)};
+
+            int x{0};
+            for (; x + 8 <= width; x += 8)
+            {
+                const __m128i mv{mask_block_means_u8_sse2<SW, SH>(mask_rows, x)};
+                const __m128i w{_mm_add_epi16(mv, _mm_srli_epi16(mv, 7))};
+                const __m128i va{_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pa + x)), zero)};
+                const __m128i vb{_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pb + x)), zero)};
+                const __m128i blend{_mm_add_epi16(
+                    _mm_add_epi16(_mm_mullo_epi16(va, _mm_sub_epi16(full, w)), _mm_mullo_epi16(vb, w)), round_blend)};
+                const __m128i result{_mm_srli_epi16(blend, 8)};
+
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(d + x), _mm_packus_epi16(result, result));
+            }
+
+            return x;
+        }
+
+        // 16-bit masked merge of 8 samples per step, with the scalar results for masks below 2^bits.
+        // The blend a * (max - w) + b * w + half is computed as (a << bits) + (b - a) * w + half modulo 2^32 (it
+        // fits in 32 bits), with w = m + (m >= max / 2), so all products are of 16-bit values.
+        template<int SW, int SH>
+        AVS_FORCEINLINE int masked_merge_row_u16_sse2(std::uint16_t* d, const std::uint16_t* pa, const std::uint16_t* pb,
+            const std::uint16_t* const (&mask_rows)[1 << SH], int width, int bits)
+        {
+            const __m128i zero{_mm_setzero_si128()};
+            const __m128i shift{_mm_cvtsi32_si128(bits)};
+            const __m128i round_blend{_mm_set1_epi32(1 << (bits - 1))};
+            const __m128i upper_half{_mm_cvtsi32_si128(bits - 1)};
+
+            int x{0};
+            for (; x + 8 <= width; x += 8)
+            {
+                const __m128i m{mask_block_means_u16_sse2<SW, SH>(mask_rows, x)};
+                const __m128i va{_mm_loadu_si128(reinterpret_cast<const __m128i*>(pa + x))};
+                const __m128i vb{_mm_loadu_si128(reinterpret_cast<const __m128i*>(pb + x))};
+                // a and b where m >> (bits - 1) is 1, for the + 1 of w.
+                const __m128i upper{_mm_cmpeq_epi16(_mm_srl_epi16(m, upper_half), zero)};
+                const __m128i ea{_mm_andnot_si128(upper, va)};
+                const __m128i eb{_mm_andnot_si128(upper, vb)};
+
+                __m128i am_lo, am_hi, bm_lo, bm_hi;
+                mask_mul_u16(va, m, am_lo, am_hi);
+                mask_mul_u16(vb, m, bm_lo, bm_hi);
+
+                const auto blend{[&](__m128i a32, __m128i am, __m128i bm, __m128i ea32, __m128i eb32) {
+                    __m128i t{_mm_add_epi32(_mm_sll_epi32(a32, shift), round_blend)};
+                    t = _mm_add_epi32(t, _mm_sub_epi32(bm, am));
+                    t = _mm_add_epi32(t, _mm_sub_epi32(eb32, ea32));
+                    return _mm_srl_epi32(t, shift);
+                }};
+
+                const __m128i lo{blend(_mm_unpacklo_epi16(va, zero), am_lo, bm_lo, _mm_unpacklo_epi16(ea, zero), _mm_unpacklo_epi16(eb, zero))};
+                const __m128i hi{blend(_mm_unpackhi_epi16(va, zero), am_hi, bm_hi, _mm_unpackhi_epi16(ea, zero), _mm_unpackhi_epi16(eb, zero))};
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(d + x), mask_pack_u32(lo, hi));
+            }
+
+            return x;
+        }
+
+        // Float masked merge of 4 samples per step, with the scalar results.
+        template<int SW, int SH>
+        AVS_FORCEINLINE int masked_merge_row_f32_sse2(
+            float* d, const float* pa, const float* pb, const float* const (&mask_rows)[1 << SH], int width)
+        {
+            int x{0};
+            for (; x + 4 <= width; x += 4)
+            {
+                const __m128 m{mask_block_means_f32_sse2<SW, SH>(mask_rows, x)};
+                const __m128 va{_mm_loadu_ps(pa + x)};
+                const __m128 vb{_mm_loadu_ps(pb + x)};
+                _mm_storeu_ps(d + x, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), m)));
+            }
+
+            return x;
+        }
+#endif
+
+        // dst = a + (b - a) * mask. Integer masks are scaled so that the maximum selects b exactly;
+        // a * (max - w) + b * w fits in 32 bits up to 16-bit samples.
+        template<typename T, int SW, int SH>
+        AVS_FORCEINLINE void masked_merge_rows(
+            plane_view<T> dst, plane_view<const T> a, plane_view<const T> b, plane_view<const T> mask, int bits)
+        {
+            const std::uint32_t max{1u << bits};
+            const std::uint32_t half{max >> 1};
+
+            for (int y{0}; y < dst.height; ++y)
+            {
+                const T* mask_rows[1 << SH];
+                for (int k{0}; k < (1 << SH); ++k)
+                    mask_rows[k] = mask.row((y << SH) + k);
+
+                T* d{dst.row(y)};
+                const T* pa{a.row(y)};
+                const T* pb{b.row(y)};
+
+                int x{0};
+#if AVS_HELPERS_MASK_SSE2
+                // Compilers vectorize the strided mask reads of subsampled planes poorly, and the integer blends
+                // not at all at -O2.
+                if constexpr (std::is_same_v<T, std::uint8_t>)
+                    x = masked_merge_row_u8_sse2<SW, SH>(d, pa, pb, mask_rows, dst.width);
+                else if constexpr (std::is_same_v<T, std::uint16_t>)
+                    x = masked_merge_row_u16_sse2<SW, SH>(d, pa, pb, mask_rows, dst.width, bits);
+                else
+                    x = masked_merge_row_f32_sse2<SW, SH>(d, pa, pb, mask_rows, dst.width);
+#endif
+
+                for (; x < dst.width; ++x)
+                {
+                    const auto m{mask_block_mean<T, SW, SH>(mask_rows, x)};
+
+                    if constexpr (std::is_same_v<T, float>)
+                        d[x] = pa[x] + (pb[x] - pa[x]) * m;
+                    else
+                    {
+                        const std::uint32_t w{m + (m >> (bits - 1))};
+                        d[x] = static_cast<T>((pa[x] * (max - w) + pb[x] * w + half) >> bits);
+                    }
+                }
+            }
+        }
+
+        template<typename T>
+        AVS_FORCEINLINE bool masked_merge_dispatch(
+            plane_view<T> dst, plane_view<const T> a, plane_view<const T> b, plane_view<const T> mask, int sub_w, int sub_h, int bits)
+        {
+            switch ((sub_w << 2) | sub_h)
+            {
+            case (0 << 2) | 0: // 4:4:4, luma, alpha
+                masked_merge_rows<T, 0, 0>(dst, a, b, mask, bits);
+                return true;
+            case (1 << 2) | 0: // 4:2:2
+                masked_merge_rows<T, 1, 0>(dst, a, b, mask, bits);
+                return true;
+            case (1 << 2) | 1: // 4:2:0
+                masked_merge_rows<T, 1, 1>(dst, a, b, mask, bits);
+                return true;
+            case (2 << 2) | 0: // 4:1:1
+                masked_merge_rows<T, 2, 0>(dst, a, b, mask, bits);
+                return true;
+            default:
+                return false;
+            }
+        }
+    } // namespace detail
+
+    /**
+     * @brief Masked merge of one plane, dst = a + (b - a) * mask, with the mask at luma resolution.
+     * For a subsampled plane the mask is averaged over each (1 << sub_w) x (1 << sub_h) block on the fly, so no
+     * per-plane mask copy is needed. dst may alias a or b.
+     * @param sub_w, sub_h log2 subsampling of the plane (avs_get_plane_width/height_subsampling); 0 for luma and
+     * alpha. Supported: 4:4:4, 4:2:2, 4:2:0 and 4:1:1.
+     * @param bits Bits per sample of integer formats (8 for std::uint8_t).
+     * @return false if the subsampling is not supported.
+     */
+    AVS_HELPERS_KERNEL inline bool masked_merge_plane(plane_view<std::uint8_t> dst, plane_view<const std::uint8_t> a,
+        plane_view<const std::uint8_t> b, plane_view<const std::uint8_t> mask, int sub_w, int sub_h)
+    {
+        return detail::masked_merge_dispatch(dst, a, b, mask, sub_w, sub_h, 8);
+    }
+
+    AVS_HELPERS_KERNEL inline bool masked_merge_plane(plane_view<std::uint16_t> dst, plane_view<const std::uint16_t> a,
+        plane_view<const std::uint16_t> b, plane_view<const std::uint16_t> mask, int sub_w, int sub_h, int bits)
+    {
+        return detail::masked_merge_dispatch(dst, a, b, mask, sub_w, sub_h, bits);
+    }
+
+    AVS_HELPERS_KERNEL inline bool masked_merge_plane(plane_view<float> dst, plane_view<const float> a, plane_view<const float> b,
+        plane_view<const float> mask, int sub_w, int sub_h)
+    {
+        return detail::masked_merge_dispatch(dst, a, b, mask, sub_w, sub_h, 0);
+    }
+
+    /**
+     * @brief Masked merge of all planes of a frame, using plane 0 of mask_frame (a luma-resolution mask of the
+     * same bit depth) for every plane.
+     * @param dst, a, b Frames of the same format; dst must be writable and may be a or b.
+     * @return false if the subsampling is not supported.
+     */
+    inline bool masked_merge(const frame_view& dst, const frame_view& a, const frame_view& b, const AVS_VideoFrame* mask_frame)
+    {
+        const int mask_plane{a.planes[0]};
+
+        for (int i{0}; i < dst.num_planes; ++i)
+        {
+            bool ok;
+            if (dst.bits == 8)
+                ok = masked_merge_plane(dst.write<std::uint8_t>(i), a.read<std::uint8_t>(i), b.read<std::uint8_t>(i),
+                    read_plane<std::uint8_t>(mask_frame, mask_plane), dst.sub_w[i], dst.sub_h[i]);
+            else if (dst.bits == 32)
+                ok = masked_merge_plane(dst.write<float>(i), a.read<float>(i), b.read<float>(i), read_plane<float>(mask_frame, mask_plane),
+                    dst.sub_w[i], dst.sub_h[i]);
+            else
+                ok = masked_merge_plane(dst.write<std::uint16_t>(i), a.read<std::uint16_t>(i), b.read<std::uint16_t>(i),
+                    read_plane<std::uint16_t>(mask_frame, mask_plane), dst.sub_w[i], dst.sub_h[i], dst.bits);
+
+            if (!ok)
+                return false;
+        }
+
+        return true;
+    }
+} // namespace avs_helpers
@@ -0,0 +1,410 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "avs_c_api_loader.hpp"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace avs_helpers
+{
+    /**
+     * @brief Coordinates the memory held by helper caches (temporal windows, prefetch buffers, scratch pools...).
+     * Each cache registers a priority and a shrink callback, and reports its size with registration::update().
+     * When the combined size passes high_watermark of the budget, or Linux PSI reports memory stalls, a background
+     * thread asks the caches to shrink, lowest priority first, down to low_watermark (PSI: by psi_shrink_fraction
+     * of the current total). Shrink callbacks run on that thread and must lock their cache themselves; update()
+     * never shrinks inline, so a cache may call it while holding its own lock. Unregistering waits for a running
+     * shrink pass, so a cache must drop its registration before it takes its own lock in its destructor.
+     */
+    class shrinker_registry
+    {
+    public:
+        /**
+         * @brief Frees about bytes_to_free bytes and returns the number of bytes actually freed.
+         * The cache must also report its new size through update().
+         */
+        using shrink_callback = std::function<std::size_t(std::size_t bytes_to_free)>;
+
+        struct statistics
+        {
+            std::size_t budget{};
+            std::size_t total{};
+            std::uint64_t shrink_passes{};
+            std::uint64_t psi_events{};
+            std::uint64_t bytes_freed{};
+            bool psi_active{}; // A PSI trigger is installed (see start()).
+        };
+
+        class registration;
+
+    private:
+        struct entry
+        {
+            int priority;
+            shrink_callback shrink;
+            std::atomic<std::size_t> bytes{};
+        };
+
+    public:
+        /**
+         * @brief RAII registration of one cache. Unregisters on destruction.
+         */
+        class registration
+        {
+        public:
+            registration() = default;
+
+            ~registration()
+            {
+                reset();
+            }
+
+            registration(const registration&) = delete;
+            registration& operator=(const registration&) = delete;
+
+            registration(registration&& other) noexcept
+                : registry_(std::exchange(other.registry_, nullptr)), entry_(std::move(other.entry_))
+            {
+            }
+
+            registration& operator=(registration&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    registry_ = std::exchange(other.registry_, nullptr);
+                    entry_ = std::move(other.entry_);
+                }
+
+                return *this;
+            }
+
+            /**
+             * @brief Reports the current size of the cache. Wakes the registry if the budget is exceeded.
+             */
+            void update(std::size_t bytes) noexcept
+            {
+                if (!registry_)
+                    return;
+
+                const std::size_t old_bytes{entry_->bytes.exchange(bytes, std::memory_order_relaxed)};
+                const std::size_t total{registry_->total_.fetch_add(bytes - old_bytes, std::memory_order_relaxed) + (bytes - old_bytes)};
+                if (bytes > old_bytes && total > registry_->high_mark())
+                    registry_->wake();
+            }
+
+            void reset()
+            {
+                if (registry_)
+                {
+                    // Waits for a running shrink pass, which may still call update() on this registration.
+                    registry_->remove(entry_);
+                    update(0);
+                    registry_ = nullptr;
+                    entry_.reset();
+                }
+            }
+
+        private:
+            friend class shrinker_registry;
+
+            shrinker_registry* registry_{};
+            std::shared_ptr<entry> entry_;
+        };
+
+        /** Fraction of the budget above which shrinking starts. */
+        double high_watermark{0.9};
+        /** Fraction of the budget shrinking aims for. */
+        double low_watermark{0.75};
+        /** Fraction of the current total freed on a PSI event. */
+        double psi_shrink_fraction{0.25};
+
+        shrinker_registry()
+        {
+#ifdef __linux__
+            // Created once for the registry's lifetime: update() may write to it from any thread at any time.
+            event_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#endif
+        }
+
+        ~shrinker_registry()
+        {
+            stop();
+
+#ifdef __linux__
+            if (event_fd_ >= 0)
+                close(event_fd_);
+#endif
+        }
+
+        shrinker_registry(const shrinker_registry&) = delete;
+        shrinker_registry& operator=(const shrinker_registry&) = delete;
+
+        /**
+         * @brief Gets the process-wide registry.
+         */
+        static shrinker_registry& shared()
+        {
+            static shrinker_registry registry;
+            return registry;
+        }
+
+        /**
+         * @brief Registers a cache.
+         * @param priority Caches with lower priority are shrunk first (e.g. 0 for cheap-to-refill scratch pools).
+         */
+        registration add(int priority, shrink_callback shrink)
+        {
+            registration r;
+            r.registry_ = this;
+            r.entry_ = std::make_shared<entry>();
+            r.entry_->priority = priority;
+            r.entry_->shrink = std::move(shrink);
+
+            std::lock_guard lock{mutex_};
+            entries_.push_back(r.entry_);
+
+            return r;
+        }
+
+        /**
+         * @brief Sets the budget in bytes for all registered caches. 0 disables budget-driven shrinking.
+         */
+        void set_budget(std::size_t bytes) noexcept
+        {
+            budget_.store(bytes, std::memory_order_relaxed);
+            wake();
+        }
+
+        /**
+         * @brief Sets the budget to a fraction of the environment's frame cache limit (avs_set_memory_max).
+         * The helper caches share the process with that cache, so fraction is usually well below 1.
+         */
+        void set_budget_from_env(AVS_ScriptEnvironment* env, double fraction = 0.25)
+        {
+            // A value <= 0 only queries the current limit (MiB).
+            const int max_mb{g_avs_api->avs_set_memory_max(env, 0)};
+            set_budget((max_mb > 0) ? static_cast<std::size_t>(static_cast<double>(max_mb) * fraction * 1024.0 * 1024.0) : 0);
+        }
+
+        /**
+         * @brief Starts the background thread.
+         * @param psi_stall_us Linux: react when tasks stall on memory for this long (some) within psi_window_us;
+         * 0 to disable PSI. Ignored where /proc/pressure/memory is unavailable or the trigger is rejected (see
+         * statistics::psi_active).
+         * @param psi_window_us PSI window. Unprivileged processes may only use multiples of 2 s.
+         * @return false if the thread is already running.
+         */
+        bool start(unsigned psi_stall_us = 150000, unsigned psi_window_us = 2000000)
+        {
+            if (worker_.joinable())
+                return false;
+
+            stop_ = false;
+
+#ifdef __linux__
+            if (psi_stall_us)
+            {
+                psi_fd_ = open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+                if (psi_fd_ >= 0)
+                {
+                    const std::string trigger{"some " + std::to_string(psi_stall_us) + " " + std::to_string(psi_window_us)};
+                    if (write(psi_fd_, trigger.c_str(), trigger.size() + 1) < 0)
+                    {
+                        close(psi_fd_);
+                        psi_fd_ = -1;
+                    }
+                }
+            }
+            psi_active_.store(psi_fd_ >= 0, std::memory_order_relaxed);
+#endif
+
+            worker_ = std::thread([this] { run(); });
+
+            return true;
+        }
+
+        void stop()
+        {
+            if (!worker_.joinable())
+                return;
+
+            {
+                std::lock_guard lock{mutex_};
+                stop_ = true;
+            }
+            wake();
+            worker_.join();
+
+#ifdef __linux__
+            if (psi_fd_ >= 0)
+                close(psi_fd_);
+            psi_fd_ = -1;
+            psi_active_.store(false, std::memory_order_relaxed);
+#endif
+        }
+
+        /**
+         * @brief Shrinks the caches, lowest priority first, until bytes_to_free are freed or nothing is left.
+         * Runs on the calling thread; must not be called while holding a cache lock.
+         * @return The number of bytes freed.
+         */
+        std::size_t shrink(std::size_t bytes_to_free)
+        {
+            std::lock_guard shrink_lock{shrink_mutex_};
+
+            std::vector<std::shared_ptr<entry>> order;
+            {
+                std::lock_guard lock{mutex_};
+                order = entries_;
+            }
+
+            std::stable_sort(order.begin(), order.end(), [](const auto& a, const auto& b) {
+                if (a->priority != b->priority)
+                    return a->priority < b->priority;
+                return a->bytes.load(std::memory_order_relaxed) > b->bytes.load(std::memory_order_relaxed);
+            });
+
+            std::size_t freed{};
+            for (const auto& e : order)
+            {
+                if (freed >= bytes_to_free)
+                    break;
+                if (e->bytes.load(std::memory_order_relaxed))
+                    freed += e->shrink(bytes_to_free - freed);
+            }
+
+            shrink_passes_.fetch_add(1, std::memory_order_relaxed);
+            bytes_freed_.fetch_add(freed, std::memory_order_relaxed);
+
+            return freed;
+        }
+
+        statistics stats() const noexcept
+        {
+            return {budget_.load(std::memory_order_relaxed), total_.load(std::memory_order_relaxed),
+                shrink_passes_.load(std::memory_order_relaxed), psi_events_.load(std::memory_order_relaxed),
+                bytes_freed_.load(std::memory_order_relaxed), psi_active_.load(std::memory_order_relaxed)};
+        }
+
+    private:
+        std::size_t high_mark() const noexcept
+        {
+            const std::size_t budget{budget_.load(std::memory_order_relaxed)};
+            return (budget) ? static_cast<std::size_t>(static_cast<double>(budget) * high_watermark) : SIZE_MAX;
+        }
+
+        void wake() noexcept
+        {
+#ifdef __linux__
+            if (event_fd_ >= 0)
+            {
+                const std::uint64_t one{1};
+                [[maybe_unused]] const auto r{write(event_fd_, &one, sizeof(one))};
+                return;
+            }
+#endif
+            std::lock_guard lock{mutex_};
+            wakeups_++;
+            wake_cv_.notify_one();
+        }
+
+        void remove(const std::shared_ptr<entry>& e)
+        {
+            // After this no shrink pass can call the entry's callback.
+            std::lock_guard shrink_lock{shrink_mutex_};
+            std::lock_guard lock{mutex_};
+            std::erase(entries_, e);
+        }
+
+        // Waits for a wakeup or a PSI event. Returns false when stopping.
+        bool wait_event(bool& psi_event)
+        {
+            psi_event = false;
+
+#ifdef __linux__
+            if (event_fd_ >= 0)
+            {
+                pollfd fds[2]{{event_fd_, POLLIN, 0}, {psi_fd_, POLLPRI, 0}};
+                if (poll(fds, (psi_fd_ >= 0) ? 2 : 1, -1) > 0)
+                {
+                    if (fds[0].revents & POLLIN)
+                    {
+                        std::uint64_t count;
+                        [[maybe_unused]] const auto r{read(event_fd_, &count, sizeof(count))};
+                    }
+                    psi_event = psi_fd_ >= 0 && (fds[1].revents & POLLPRI);
+                }
+
+                std::lock_guard lock{mutex_};
+                return !stop_;
+            }
+#endif
+
+            std::unique_lock lock{mutex_};
+            wake_cv_.wait(lock, [&] { return stop_ || wakeups_; });
+            wakeups_ = 0;
+
+            return !stop_;
+        }
+
+        void run()
+        {
+            bool psi_event;
+            while (wait_event(psi_event))
+            {
+                const std::size_t total{total_.load(std::memory_order_relaxed)};
+
+                if (psi_event)
+                {
+                    psi_events_.fetch_add(1, std::memory_order_relaxed);
+                    shrink(static_cast<std::size_t>(static_cast<double>(total) * psi_shrink_fraction));
+                }
+                else if (total > high_mark())
+                {
+                    const auto target{static_cast<std::size_t>(static_cast<double>(budget_.load(std::memory_order_relaxed)) * low_watermark)};
+                    shrink(total - std::min(total, target));
+                }
+            }
+        }
+
+        std::vector<std::shared_ptr<entry>> entries_;
+        std::atomic<std::size_t> total_{};
+        std::atomic<std::size_t> budget_{};
+        std::atomic<std::uint64_t> shrink_passes_{};
+        std::atomic<std::uint64_t> psi_events_{};
+        std::atomic<std::uint64_t> bytes_freed_{};
+        std::atomic<bool> psi_active_{};
+        std::thread worker_;
+        std::mutex mutex_;
+        std::mutex shrink_mutex_;
+        std::condition_variable wake_cv_;
+        unsigned wakeups_{};
+        bool stop_{};
+#ifdef __linux__
+        // Set in the constructor and closed in the destructor only.
+        int event_fd_{-1};
+        // Owned by start()/stop() and read by the worker thread between them.
+        int psi_fd_{-1};
+#endif
+    };
+} // namespace avs_helpers
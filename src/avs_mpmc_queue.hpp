@@ -0,0 +1,263 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace avs_helpers
+{
+    // Fixed rather than std::hardware_destructive_interference_size, which may differ between translation units.
+    inline constexpr std::size_t cache_line_size{64};
+
+    /**
+     * @brief Bounded lock-free multi-producer/multi-consumer queue (Dmitry Vyukov's sequence-numbered ring).
+     * try_push/try_pop never lock. The blocking, spinning and timed variants fall back to a mutex and condition
+     * variable only to sleep, and producers/consumers touch them only while someone is asleep.
+     * @tparam T Element type (e.g. avs_video_frame_ptr). Must be default constructible and movable.
+     */
+    template<typename T>
+    class mpmc_queue
+    {
+    public:
+        /**
+         * @param capacity Maximum number of queued elements; rounded up to a power of two (at least 2).
+         */
+        explicit mpmc_queue(std::size_t capacity)
+        {
+            std::size_t size{2};
+            while (size < capacity)
+                size *= 2;
+
+            mask_ = size - 1;
+            cells_ = std::make_unique<cell[]>(size);
+            for (std::size_t i{0}; i < size; ++i)
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        mpmc_queue(const mpmc_queue&) = delete;
+        mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+        /**
+         * @brief Pushes an element if there is room.
+         * @return false if the queue is full (value is left untouched).
+         */
+        bool try_push(T& value)
+        {
+            std::size_t pos{enqueue_pos_.load(std::memory_order_relaxed)};
+            cell* c;
+
+            for (;;)
+            {
+                c = &cells_[pos & mask_];
+                const std::size_t seq{c->sequence.load(std::memory_order_acquire)};
+                const std::intptr_t diff{static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos)};
+
+                if (diff == 0)
+                {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+
+            c->value = std::move(value);
+            c->sequence.store(pos + 1, std::memory_order_release);
+            signal(not_empty_, pushed_);
+
+            return true;
+        }
+
+        /**
+         * @brief Pops an element if one is available.
+         * @return false if the queue is empty.
+         */
+        bool try_pop(T& value)
+        {
+            std::size_t pos{dequeue_pos_.load(std::memory_order_relaxed)};
+            cell* c;
+
+            for (;;)
+            {
+                c = &cells_[pos & mask_];
+                const std::size_t seq{c->sequence.load(std::memory_order_acquire)};
+                const std::intptr_t diff{static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1)};
+
+                if (diff == 0)
+                {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+
+            value = std::move(c->value);
+            c->sequence.store(pos + mask_ + 1, std::memory_order_release);
+            signal(not_full_, popped_);
+
+            return true;
+        }
+
+        /**
+         * @brief Pushes an element, sleeping while the queue is full.
+         * @param stop Checked while waiting; close() wakes all waiters after it is set.
+         * @return false if stop was set before there was room.
+         */
+        bool push(T& value, const std::atomic<bool>& stop)
+        {
+            return wait_until(not_full_, popped_, stop, std::chrono::steady_clock::time_point::max(),
+                [&] { return try_push(value); });
+        }
+
+        /**
+         * @brief Pops an element, sleeping while the queue is empty.
+         * @param stop Checked while waiting; close() wakes all waiters after it is set.
+         * @return false if stop was set before an element arrived.
+         */
+        bool pop(T& value, const std::atomic<bool>& stop)
+        {
+            return wait_until(not_empty_, pushed_, stop, std::chrono::steady_clock::time_point::max(),
+                [&] { return try_pop(value); });
+        }
+
+        /**
+         * @brief Pops an element, busy-waiting for at most spins attempts. For latency-critical consumers
+         * that own a core; nothing sleeps.
+         * @return false if the queue stayed empty.
+         */
+        bool pop_spin(T& value, unsigned spins)
+        {
+            for (unsigned i{0}; i <= spins; ++i)
+            {
+                if (try_pop(value))
+                    return true;
+
+                cpu_relax();
+            }
+
+            return false;
+        }
+
+        /**
+         * @brief Pops an element, sleeping for at most timeout while the queue is empty.
+         * @return false on timeout or if stop was set.
+         */
+        template<typename Rep, typename Period>
+        bool pop_for(T& value, const std::chrono::duration<Rep, Period>& timeout, const std::atomic<bool>& stop)
+        {
+            return wait_until(not_empty_, pushed_, stop, std::chrono::steady_clock::now() + timeout,
+                [&] { return try_pop(value); });
+        }
+
+        /**
+         * @brief Wakes all sleeping push/pop calls so they re-check their stop flag.
+         */
+        void close()
+        {
+            std::lock_guard lock{mutex_};
+            not_empty_.notify_all();
+            not_full_.notify_all();
+        }
+
+        std::size_t capacity() const noexcept
+        {
+            return mask_ + 1;
+        }
+
+    private:
+        struct alignas(cache_line_size) cell
+        {
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+
+        static void cpu_relax() noexcept
+        {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+            __builtin_ia32_pause();
+#elif defined(__aarch64__)
+            asm volatile("yield");
+#else
+            std::this_thread::yield();
+#endif
+        }
+
+        // Dekker-style handshake with wait_until: the fence orders the published cell before the waiters_ load, and
+        // a sleeper increments waiters_ before its last attempt. Either the sleeper sees the element, or this sees
+        // the sleeper and bumps the counter under the mutex. Without sleepers the fast path touches no shared line.
+        void signal(std::condition_variable& cv, std::atomic<std::uint64_t>& counter)
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiters_.load(std::memory_order_relaxed))
+            {
+                std::lock_guard lock{mutex_};
+                counter.fetch_add(1, std::memory_order_relaxed);
+                cv.notify_all();
+            }
+        }
+
+        template<typename Try>
+        bool wait_until(std::condition_variable& cv, const std::atomic<std::uint64_t>& counter, const std::atomic<bool>& stop,
+            std::chrono::steady_clock::time_point deadline, Try&& attempt)
+        {
+            if (attempt())
+                return true;
+
+            waiters_.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool result{false};
+
+            for (;;)
+            {
+                std::uint64_t seen;
+                {
+                    std::lock_guard lock{mutex_};
+                    seen = counter.load(std::memory_order_relaxed);
+                }
+                if (attempt())
+                {
+                    result = true;
+                    break;
+                }
+                if (stop.load(std::memory_order_acquire))
+                    break;
+
+                std::unique_lock lock{mutex_};
+                const auto changed{[&] { return counter.load(std::memory_order_relaxed) != seen || stop.load(std::memory_order_acquire); }};
+                if (deadline == std::chrono::steady_clock::time_point::max())
+                    cv.wait(lock, changed);
+                else if (!cv.wait_until(lock, deadline, changed))
+                    break;
+            }
+
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+
+            return result;
+        }
+
+        std::unique_ptr<cell[]> cells_;
+        std::size_t mask_{};
+        alignas(cache_line_size) std::atomic<std::size_t> enqueue_pos_{};
+        alignas(cache_line_size) std::atomic<std::size_t> dequeue_pos_{};
+        alignas(cache_line_size) std::atomic<std::uint32_t> waiters_{};
+        // Sleeper state, written only under mutex_.
+        alignas(cache_line_size) std::atomic<std::uint64_t> pushed_{};
+        std::atomic<std::uint64_t> popped_{};
+        std::mutex mutex_;
+        std::condition_variable not_empty_;
+        std::condition_variable not_full_;
+    };
+} // namespace avs_helpers
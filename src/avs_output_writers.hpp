@@ -0,0 +1,617 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "avs_c_api_loader.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace avs_helpers
+{
+    namespace detail
+    {
+#ifdef _WIN32
+        struct io_segment
+        {
+            void* iov_base;
+            std::size_t iov_len;
+        };
+        inline constexpr int max_io_segments{1024};
+#else
+        using io_segment = iovec;
+#ifdef IOV_MAX
+        inline constexpr int max_io_segments{IOV_MAX};
+#else
+        inline constexpr int max_io_segments{1024};
+#endif
+#endif
+
+        /**
+         * @brief Writes all segments to fd, with writev where available. Handles partial writes, EINTR and
+         * (for non-blocking descriptors) EAGAIN. The segments are modified.
+         * @return 0 on success, otherwise the errno value.
+         */
+        inline int write_segments(int fd, io_segment* seg, int count)
+        {
+            while (count > 0)
+            {
+#ifdef _WIN32
+                const int written{_write(fd, seg->iov_base, static_cast<unsigned>(seg->iov_len))};
+#else
+                const ssize_t written{::writev(fd, seg, (count < max_io_segments) ? count : max_io_segments)};
+#endif
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+#ifndef _WIN32
+                    if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    {
+                        pollfd pfd{fd, POLLOUT, 0};
+                        ::poll(&pfd, 1, -1);
+                        continue;
+                    }
+#endif
+                    return errno;
+                }
+
+                std::size_t remaining{static_cast<std::size_t>(written)};
+                while (count > 0 && remaining >= seg->iov_len)
+                {
+                    remaining -= seg->iov_len;
+                    ++seg;
+                    --count;
+                }
+                if (count > 0 && remaining > 0)
+                {
+                    seg->iov_base = static_cast<char*>(seg->iov_base) + remaining;
+                    seg->iov_len -= remaining;
+                }
+            }
+
+            return 0;
+        }
+
+        /**
+         * @brief Tries to resize a pipe buffer (Linux F_SETPIPE_SZ).
+         * @return The resulting pipe buffer size, or 0 if fd is not a pipe or the platform does not support it.
+         */
+        inline std::size_t set_pipe_buffer_size(int fd, std::size_t size)
+        {
+#if defined(__linux__) && defined(F_SETPIPE_SZ)
+            if (size)
+                ::fcntl(fd, F_SETPIPE_SZ, static_cast<int>(size));
+
+            const int current{::fcntl(fd, F_GETPIPE_SZ)};
+            return (current > 0) ? static_cast<std::size_t>(current) : 0;
+#else
+            (void)fd;
+            (void)size;
+            return 0;
+#endif
+        }
+
+        /**
+         * @brief Checks whether fd was opened with O_DIRECT (Linux).
+         */
+        inline bool is_direct_io(int fd)
+        {
+#if defined(__linux__) && defined(O_DIRECT)
+            const int flags{::fcntl(fd, F_GETFL)};
+            return flags >= 0 && (flags & O_DIRECT);
+#else
+            (void)fd;
+            return false;
+#endif
+        }
+
+        /**
+         * @brief Enables or disables O_DIRECT on fd (Linux). Used for the unaligned tail of a direct stream.
+         */
+        inline void set_direct_io(int fd, bool enable)
+        {
+#if defined(__linux__) && defined(O_DIRECT)
+            const int flags{::fcntl(fd, F_GETFL)};
+            if (flags >= 0)
+                ::fcntl(fd, F_SETFL, (enable) ? (flags | O_DIRECT) : (flags & ~O_DIRECT));
+#else
+            (void)fd;
+            (void)enable;
+#endif
+        }
+
+        struct aligned_buffer_deleter
+        {
+            std::size_t alignment;
+            void operator()(std::byte* ptr) const noexcept
+            {
+                ::operator delete(ptr, std::align_val_t{alignment});
+            }
+        };
+        using aligned_buffer = std::unique_ptr<std::byte[], aligned_buffer_deleter>;
+
+        inline aligned_buffer make_aligned_buffer(std::size_t size, std::size_t alignment)
+        {
+            return aligned_buffer{static_cast<std::byte*>(::operator new(size, std::align_val_t{alignment})), {alignment}};
+        }
+    } // namespace detail
+
+    /**
+     * @brief Writes video frames as Y4M or raw planar data to a file descriptor (file or pipe) without an
+     * intermediate copy: the plane pointers of each frame are handed to writev directly, one segment per
+     * plane when the pitch equals the row size, otherwise one segment per row (skipping the pitch padding).
+     * Planar YUV(A) is written as Y, U, V, (A); planar RGB(A) as G, B, R, (A); packed formats as stored.
+     * Y4M supports 8-16 bit Y and YUV formats; alpha is only written for 8-bit 4:4:4 ("444alpha").
+     */
+    class frame_writer
+    {
+    public:
+        enum class format
+        {
+            raw,
+            y4m,
+        };
+
+        /**
+         * @brief Prepares the writer and, for Y4M, writes the stream header.
+         * @param fd Destination file descriptor. Not closed by the writer.
+         * @param vi Video info of the frames that will be written.
+         * @param fmt Output format.
+         * @param pipe_buffer_size If non-zero and fd is a pipe, request this pipe buffer size (Linux F_SETPIPE_SZ).
+         * @return false on error (see last_error()).
+         */
+        bool open(int fd, const AVS_VideoInfo& vi, format fmt, std::size_t pipe_buffer_size = 0)
+        {
+            fd_ = fd;
+            last_error_.clear();
+            planes_.clear();
+
+            int planes[4];
+            const int num_planes{get_planes(vi, planes)};
+            const bool alpha{num_planes == 4};
+            planes_.assign(planes, planes + num_planes);
+
+            pipe_buffer_size_ = detail::set_pipe_buffer_size(fd, pipe_buffer_size);
+            frame_header_ = (fmt == format::y4m);
+
+            if (fmt == format::y4m)
+            {
+                const char* colorspace{y4m_colorspace(vi)};
+                if (!colorspace)
+                {
+                    last_error_ = "frame_writer: the clip format is not supported by Y4M.";
+                    return false;
+                }
+
+                if (alpha && std::strcmp(colorspace, "444alpha") != 0)
+                    planes_.pop_back();
+
+                const char interlace{(vi.image_type & AVS_IT_TFF) ? 't' : (vi.image_type & AVS_IT_BFF) ? 'b' : 'p'};
+                char header[128];
+                const int size{std::snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%u:%u I%c A0:0 C%s\n", vi.width,
+                    vi.height, vi.fps_numerator, vi.fps_denominator, interlace, colorspace)};
+
+                detail::io_segment seg{header, static_cast<std::size_t>(size)};
+                return check(detail::write_segments(fd_, &seg, 1));
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Writes one frame.
+         * @param frame The frame. Its format must match the video info passed to open().
+         * @return false on error (see last_error()).
+         */
+        bool write_frame(const AVS_VideoFrame* frame)
+        {
+            static constexpr char frame_tag[]{"FRAME\n"};
+
+            segments_.clear();
+            if (frame_header_)
+                segments_.push_back({const_cast<char*>(frame_tag), sizeof(frame_tag) - 1});
+
+            for (const int plane : planes_)
+            {
+                const int row_size{g_avs_api->avs_get_row_size_p(frame, plane)};
+                const int height{g_avs_api->avs_get_height_p(frame, plane)};
+                const int pitch{g_avs_api->avs_get_pitch_p(frame, plane)};
+                const BYTE* src{g_avs_api->avs_get_read_ptr_p(frame, plane)};
+
+                if (pitch == row_size)
+                {
+                    segments_.push_back({const_cast<BYTE*>(src), static_cast<std::size_t>(row_size) * height});
+                }
+                else
+                {
+                    for (int y{0}; y < height; ++y)
+                        segments_.push_back({const_cast<BYTE*>(src + static_cast<std::ptrdiff_t>(y) * pitch),
+                            static_cast<std::size_t>(row_size)});
+                }
+            }
+
+            return check(detail::write_segments(fd_, segments_.data(), static_cast<int>(segments_.size())));
+        }
+
+        /**
+         * @brief Gets the pipe buffer size in effect (0 if fd is not a pipe or it cannot be queried).
+         */
+        std::size_t pipe_buffer_size() const noexcept
+        {
+            return pipe_buffer_size_;
+        }
+
+        /**
+         * @brief Gets the last error message. Empty if there was no error.
+         */
+        const std::string& last_error() const noexcept
+        {
+            return last_error_;
+        }
+
+    private:
+        static const char* y4m_colorspace(const AVS_VideoInfo& vi)
+        {
+            if (!(vi.pixel_type & AVS_CS_PLANAR) || g_avs_api->avs_is_planar_rgb(&vi) || g_avs_api->avs_is_planar_rgba(&vi))
+                return nullptr;
+
+            const int bits{g_avs_api->avs_bits_per_component(&vi)};
+            if (bits > 16)
+                return nullptr;
+
+            const int depth_index{(bits == 8) ? 0 : (bits == 10) ? 1 : (bits == 12) ? 2 : (bits == 14) ? 3 : 4};
+
+            if (g_avs_api->avs_is_y(&vi))
+            {
+                static constexpr const char* names[]{"mono", "mono10", "mono12", "mono14", "mono16"};
+                return names[depth_index];
+            }
+            // Y4M only defines an alpha variant for 8-bit 4:4:4; other YUVA formats are written without alpha.
+            if (g_avs_api->avs_is_yuva(&vi) && bits == 8 && g_avs_api->avs_is_444(&vi))
+                return "444alpha";
+            if (g_avs_api->avs_is_420(&vi))
+            {
+                static constexpr const char* names[]{"420jpeg", "420p10", "420p12", "420p14", "420p16"};
+                return names[depth_index];
+            }
+            if (g_avs_api->avs_is_422(&vi))
+            {
+                static constexpr const char* names[]{"422", "422p10", "422p12", "422p14", "422p16"};
+                return names[depth_index];
+            }
+            if (g_avs_api->avs_is_444(&vi))
+            {
+                static constexpr const char* names[]{"444", "444p10", "444p12", "444p14", "444p16"};
+                return names[depth_index];
+            }
+            if (g_avs_api->avs_is_yv411(&vi))
+                return (bits == 8) ? "411" : nullptr;
+
+            return nullptr;
+        }
+
+        bool check(int error)
+        {
+            if (error)
+            {
+                last_error_ = "frame_writer: write failed: ";
+                last_error_ += std::strerror(error);
+                return false;
+            }
+
+            return true;
+        }
+
+        int fd_{-1};
+        bool frame_header_{};
+        std::size_t pipe_buffer_size_{};
+        std::vector<int> planes_;
+        std::vector<detail::io_segment> segments_;
+        std::string last_error_;
+    };
+
+    /**
+     * @brief Streams the whole audio track of a clip as WAV or raw PCM to a file descriptor.
+     * A reader thread fetches large chunks with avs_get_audio into two aligned buffers while the calling
+     * thread writes the other one (writev for header + data).
+     * If fd was opened with O_DIRECT (Linux), chunks are sized to multiples of the 4096-byte alignment and
+     * the WAV header is padded to one block with a JUNK chunk, so every write except the final tail is aligned.
+     * WAV uses WAVE_FORMAT_EXTENSIBLE for more than 2 channels or more than 16 bits.
+     */
+    class audio_writer
+    {
+    public:
+        enum class format
+        {
+            raw,
+            wav,
+        };
+
+        static constexpr std::size_t default_chunk_bytes{std::size_t{4} << 20};
+        static constexpr std::size_t io_alignment{4096};
+
+        /**
+         * @brief Writes all audio samples of the clip.
+         * @param clip The clip.
+         * @param fd Destination file descriptor. Not closed by the writer.
+         * @param fmt Output format.
+         * @param chunk_bytes Approximate size of each avs_get_audio request.
+         * @return false on error (see last_error()).
+         */
+        bool write(AVS_Clip* clip, int fd, format fmt, std::size_t chunk_bytes = default_chunk_bytes)
+        {
+            last_error_.clear();
+            bytes_written_ = 0;
+
+            const AVS_VideoInfo& vi{*g_avs_api->avs_get_video_info(clip)};
+            const int bytes_per_sample{sample_size(vi.sample_type)};
+            if (vi.num_audio_samples <= 0 || vi.nchannels <= 0 || !bytes_per_sample)
+            {
+                last_error_ = "audio_writer: the clip has no audio.";
+                return false;
+            }
+
+            const std::size_t frame_bytes{static_cast<std::size_t>(bytes_per_sample) * vi.nchannels};
+            const bool direct{detail::is_direct_io(fd)};
+
+            // Chunks hold whole sample frames; with O_DIRECT they are also a multiple of io_alignment bytes.
+            std::size_t frames_per_chunk{(chunk_bytes > frame_bytes) ? chunk_bytes / frame_bytes : 1};
+            if (direct)
+            {
+                const std::size_t step{io_alignment / gcd(io_alignment, frame_bytes)};
+                frames_per_chunk = ((frames_per_chunk + step - 1) / step) * step;
+            }
+
+            const std::size_t buffer_bytes{frames_per_chunk * frame_bytes};
+            detail::aligned_buffer buffers[2]{
+                detail::make_aligned_buffer(buffer_bytes, io_alignment), detail::make_aligned_buffer(buffer_bytes, io_alignment)};
+
+            detail::aligned_buffer header{detail::make_aligned_buffer(io_alignment, io_alignment)};
+            std::size_t header_size{};
+            if (fmt == format::wav)
+                header_size = make_wav_header(vi, bytes_per_sample, direct, header.get());
+
+            const std::int64_t total_frames{vi.num_audio_samples};
+            const std::int64_t chunk_count{(total_frames + static_cast<std::int64_t>(frames_per_chunk) - 1) /
+                static_cast<std::int64_t>(frames_per_chunk)};
+
+            // produced: chunks filled by the reader; consumed: chunks written. Buffer i % 2 holds chunk i.
+            // A side that fails sets failed and moves its counter to aborted, so that the other side's wait returns
+            // (atomic wait only wakes up on a change of value).
+            constexpr std::int64_t aborted{std::numeric_limits<std::int64_t>::max()};
+            std::atomic<std::int64_t> produced{0};
+            std::atomic<std::int64_t> consumed{0};
+            std::atomic<bool> failed{false};
+            const char* read_error{};
+
+            std::thread reader{[&] {
+                for (std::int64_t i{0}; i < chunk_count; ++i)
+                {
+                    // Wait until chunk i - 2 (same buffer) has been written.
+                    for (std::int64_t c{consumed.load(std::memory_order_acquire)}; c < i - 1; c = consumed.load(std::memory_order_acquire))
+                        consumed.wait(c, std::memory_order_acquire);
+                    if (failed.load(std::memory_order_acquire))
+                        return;
+
+                    const std::int64_t start{i * static_cast<std::int64_t>(frames_per_chunk)};
+                    const std::int64_t count{(total_frames - start < static_cast<std::int64_t>(frames_per_chunk))
+                            ? total_frames - start
+                            : static_cast<std::int64_t>(frames_per_chunk)};
+
+                    if (g_avs_api->avs_get_audio(clip, buffers[i % 2].get(), start, count) != 0)
+                    {
+                        read_error = g_avs_api->avs_clip_get_error(clip);
+                        failed.store(true, std::memory_order_release);
+                        produced.store(aborted, std::memory_order_release);
+                        produced.notify_one();
+                        return;
+                    }
+
+                    produced.store(i + 1, std::memory_order_release);
+                    produced.notify_one();
+                }
+            }};
+
+            int error{};
+            for (std::int64_t i{0}; i < chunk_count && !error; ++i)
+            {
+                for (std::int64_t p{produced.load(std::memory_order_acquire)}; p <= i; p = produced.load(std::memory_order_acquire))
+                    produced.wait(p, std::memory_order_acquire);
+                if (failed.load(std::memory_order_acquire))
+                    break;
+
+                const std::int64_t start{i * static_cast<std::int64_t>(frames_per_chunk)};
+                const std::size_t bytes{((total_frames - start < static_cast<std::int64_t>(frames_per_chunk))
+                        ? static_cast<std::size_t>(total_frames - start)
+                        : frames_per_chunk) *
+                    frame_bytes};
+
+                if (direct && bytes % io_alignment)
+                    detail::set_direct_io(fd, false);
+
+                detail::io_segment segments[2]{{header.get(), header_size}, {buffers[i % 2].get(), bytes}};
+                error = (i == 0 && header_size) ? detail::write_segments(fd, segments, 2)
+                                                : detail::write_segments(fd, segments + 1, 1);
+                if (!error)
+                    bytes_written_ += ((i == 0) ? header_size : 0) + bytes;
+
+                if (direct && bytes % io_alignment)
+                    detail::set_direct_io(fd, true);
+
+                consumed.store(i + 1, std::memory_order_release);
+                consumed.notify_one();
+            }
+
+            if (error)
+            {
+                failed.store(true, std::memory_order_release);
+                consumed.store(aborted, std::memory_order_release);
+                consumed.notify_one();
+            }
+            reader.join();
+
+            if (error)
+            {
+                last_error_ = "audio_writer: write failed: ";
+                last_error_ += std::strerror(error);
+                return false;
+            }
+            if (failed.load(std::memory_order_relaxed))
+            {
+                last_error_ = (read_error) ? read_error : "audio_writer: avs_get_audio failed.";
+                return false;
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Gets the number of bytes written by the last write() (header included).
+         */
+        std::uint64_t bytes_written() const noexcept
+        {
+            return bytes_written_;
+        }
+
+        /**
+         * @brief Gets the last error message. Empty if there was no error.
+         */
+        const std::string& last_error() const noexcept
+        {
+            return last_error_;
+        }
+
+    private:
+        static int sample_size(int sample_type) noexcept
+        {
+            switch (sample_type)
+            {
+            case AVS_SAMPLE_INT8:
+                return 1;
+            case AVS_SAMPLE_INT16:
+                return 2;
+            case AVS_SAMPLE_INT24:
+                return 3;
+            case AVS_SAMPLE_INT32:
+            case AVS_SAMPLE_FLOAT:
+                return 4;
+            default:
+                return 0;
+            }
+        }
+
+        static std::size_t gcd(std::size_t a, std::size_t b) noexcept
+        {
+            while (b)
+            {
+                const std::size_t t{a % b};
+                a = b;
+                b = t;
+            }
+
+            return a;
+        }
+
+        // Builds the WAV header in dst (at least io_alignment bytes). With pad_to_block the header is padded
+        // with a JUNK chunk so that the audio data starts at io_alignment.
+        static std::size_t make_wav_header(const AVS_VideoInfo& vi, int bytes_per_sample, bool pad_to_block, std::byte* dst)
+        {
+            const bool is_float{vi.sample_type == AVS_SAMPLE_FLOAT};
+            const bool extensible{vi.nchannels > 2 || bytes_per_sample > 2};
+            const std::uint32_t fmt_size{(extensible) ? 40u : 16u};
+            const std::uint64_t data_size64{static_cast<std::uint64_t>(vi.num_audio_samples) * vi.nchannels * bytes_per_sample};
+
+            std::size_t pos{};
+            const auto put{[&](const void* src, std::size_t size) {
+                std::memcpy(dst + pos, src, size);
+                pos += size;
+            }};
+            const auto put16{[&](std::uint16_t v) {
+                const std::uint8_t b[2]{static_cast<std::uint8_t>(v), static_cast<std::uint8_t>(v >> 8)};
+                put(b, 2);
+            }};
+            const auto put32{[&](std::uint32_t v) {
+                put16(static_cast<std::uint16_t>(v));
+                put16(static_cast<std::uint16_t>(v >> 16));
+            }};
+
+            std::size_t header_size{12 + 8 + fmt_size + 8};
+            std::uint32_t junk_size{};
+            if (pad_to_block)
+            {
+                junk_size = static_cast<std::uint32_t>(io_alignment - header_size - 8);
+                header_size = io_alignment;
+            }
+
+            // Sizes above 4 GiB do not fit in RIFF; readers that support it use the actual file size.
+            const std::uint32_t data_size{(data_size64 > 0xFFFFFFFFull - header_size) ? 0xFFFFFFFFu : static_cast<std::uint32_t>(data_size64)};
+            const std::uint32_t riff_size{(data_size == 0xFFFFFFFFu) ? 0xFFFFFFFFu : static_cast<std::uint32_t>(header_size - 8 + data_size)};
+            const std::uint16_t block_align{static_cast<std::uint16_t>(vi.nchannels * bytes_per_sample)};
+
+            put("RIFF", 4);
+            put32(riff_size);
+            put("WAVE", 4);
+
+            put("fmt ", 4);
+            put32(fmt_size);
+            put16((extensible) ? 0xFFFE : (is_float) ? 3 : 1);
+            put16(static_cast<std::uint16_t>(vi.nchannels));
+            put32(static_cast<std::uint32_t>(vi.audio_samples_per_second));
+            put32(static_cast<std::uint32_t>(vi.audio_samples_per_second) * block_align);
+            put16(block_align);
+            put16(static_cast<std::uint16_t>(bytes_per_sample * 8));
+
+            if (extensible)
+            {
+                const bool mask_known{g_avs_api->avs_is_channel_mask_known && g_avs_api->avs_get_channel_mask &&
+                    g_avs_api->avs_is_channel_mask_known(&vi)};
+
+                put16(22);
+                put16(static_cast<std::uint16_t>(bytes_per_sample * 8));
+                put32((mask_known) ? static_cast<std::uint32_t>(g_avs_api->avs_get_channel_mask(&vi)) : 0);
+                // KSDATAFORMAT_SUBTYPE_PCM / KSDATAFORMAT_SUBTYPE_IEEE_FLOAT
+                static constexpr std::uint8_t guid_tail[14]{
+                    0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+                put16((is_float) ? 3 : 1);
+                put(guid_tail, sizeof(guid_tail));
+            }
+
+            if (pad_to_block)
+            {
+                put("JUNK", 4);
+                put32(junk_size);
+                std::memset(dst + pos, 0, junk_size);
+                pos += junk_size;
+            }
+
+            put("data", 4);
+            put32(data_size);
+
+            return pos;
+        }
+
+        std::uint64_t bytes_written_{};
+        std::string last_error_;
+    };
+} // namespace avs_helpers
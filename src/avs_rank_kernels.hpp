@@ -0,0 +1,491 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "avs_cpu_dispatch.hpp"
+#include "avs_frame_view.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#if defined(__SSE4_1__) || defined(__AVX__)
+#include <smmintrin.h>
+#endif
+#define AVS_HELPERS_RANK_SSE2 1
+#else
+#define AVS_HELPERS_RANK_SSE2 0
+#endif
+
+namespace avs_helpers
+{
+    /**
+     * @brief How samples outside the plane are read by neighbourhood kernels.
+     */
+    enum class border_mode
+    {
+        replicate, // edge sample repeated: ... a a | a b c
+        mirror     // reflected without repeating the edge: ... c b | a b c
+    };
+
+    namespace detail
+    {
+        AVS_FORCEINLINE int border_index(int i, int size, border_mode mode) noexcept
+        {
+            if (i >= 0 && i < size)
+                return i;
+            if (mode == border_mode::replicate || size == 1)
+                return std::clamp(i, 0, size - 1);
+
+            // Mirror, folded again for radii larger than the plane.
+            const int period{2 * (size - 1)};
+            i = (i < 0) ? -i : i;
+            i %= period;
+            return (i < size) ? i : period - i;
+        }
+
+        // Compare-exchange of a selection network. kind: 0 both outputs are used, 1 only the min (into lo),
+        // 2 only the max (into hi).
+        struct network_op
+        {
+            int lo;
+            int hi;
+            int kind;
+        };
+
+        inline constexpr int rank_network_max_size{25};
+
+        struct selection_network
+        {
+            std::array<network_op, 256> ops{};
+            int count{};
+        };
+
+        // Batcher's odd-even merge sort of n elements pruned to the comparators that output `rank` depends on
+        // (walking the network backwards from that output). Comparators whose other output is dead keep only
+        // their min or max.
+        constexpr selection_network make_selection_network(int n, int rank)
+        {
+            selection_network full{};
+            for (int p{1}; p < n; p *= 2)
+            {
+                for (int k{p}; k >= 1; k /= 2)
+                {
+                    for (int j{k % p}; j + k < n; j += 2 * k)
+                    {
+                        for (int i{0}; i < std::min(k, n - j - k); ++i)
+                        {
+                            if ((i + j) / (p * 2) == (i + j + k) / (p * 2))
+                                full.ops[full.count++] = {i + j, i + j + k, 0};
+                        }
+                    }
+                }
+            }
+
+            std::array<bool, rank_network_max_size> needed{};
+            needed[rank] = true;
+
+            selection_network pruned{};
+            for (int i{full.count - 1}; i >= 0; --i)
+            {
+                const network_op op{full.ops[i]};
+                if (!needed[op.lo] && !needed[op.hi])
+                    continue;
+
+                pruned.ops[pruned.count++] = {op.lo, op.hi, (needed[op.lo] && needed[op.hi]) ? 0 : (needed[op.lo] ? 1 : 2)};
+                needed[op.lo] = true;
+                needed[op.hi] = true;
+            }
+
+            std::reverse(pruned.ops.begin(), pruned.ops.begin() + pruned.count);
+
+            return pruned;
+        }
+
+        template<int N, int Rank>
+        inline constexpr selection_network rank_network{make_selection_network(N, Rank)};
+
+        // Vector operations for one sample type; the scalar variant handles borders and tails with the same network.
+        template<typename T>
+        struct scalar_lanes
+        {
+            using vec = T;
+            static constexpr int lanes{1};
+
+            static AVS_FORCEINLINE vec load(const T* p)
+            {
+                return *p;
+            }
+
+            static AVS_FORCEINLINE void store(T* p, vec v)
+            {
+                *p = v;
+            }
+
+            static AVS_FORCEINLINE vec min(vec a, vec b)
+            {
+                return (b < a) ? b : a;
+            }
+
+            static AVS_FORCEINLINE vec max(vec a, vec b)
+            {
+                return (a < b) ? b : a;
+            }
+        };
+
+#if AVS_HELPERS_RANK_SSE2
+        template<typename T>
+        struct sse2_lanes;
+
+        template<>
+        struct sse2_lanes<std::uint8_t>
+        {
+            using vec = __m128i;
+            static constexpr int lanes{16};
+
+            static AVS_FORCEINLINE vec load(const std::uint8_t* p)
+            {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            }
+
+            static AVS_FORCEINLINE void store(std::uint8_t* p, vec v)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+            }
+
+            static AVS_FORCEINLINE vec min(vec a, vec b)
+            {
+                return _mm_min_epu8(a, b);
+            }
+
+            static AVS_FORCEINLINE vec max(vec a, vec b)
+            {
+                return _mm_max_epu8(a, b);
+            }
+        };
+
+        template<>
+        struct sse2_lanes<std::uint16_t>
+        {
+            using vec = __m128i;
+            static constexpr int lanes{8};
+
+            static AVS_FORCEINLINE vec load(const std::uint16_t* p)
+            {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            }
+
+            static AVS_FORCEINLINE void store(std::uint16_t* p, vec v)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+            }
+
+            // SSE2 has no unsigned 16-bit min/max: a - (a -sat b) and b + (a -sat b).
+            static AVS_FORCEINLINE vec min(vec a, vec b)
+            {
+#if defined(__SSE4_1__) || defined(__AVX__)
+                return _mm_min_epu16(a, b);
+#else
+                return _mm_sub_epi16(a, _mm_subs_epu16(a, b));
+#endif
+            }
+
+            static AVS_FORCEINLINE vec max(vec a, vec b)
+            {
+#if defined(__SSE4_1__) || defined(__AVX__)
+                return _mm_max_epu16(a, b);
+#else
+                return _mm_add_epi16(b, _mm_subs_epu16(a, b));
+#endif
+            }
+        };
+
+        template<>
+        struct sse2_lanes<float>
+        {
+            using vec = __m128;
+            static constexpr int lanes{4};
+
+            static AVS_FORCEINLINE vec load(const float* p)
+            {
+                return _mm_loadu_ps(p);
+            }
+
+            static AVS_FORCEINLINE void store(float* p, vec v)
+            {
+                _mm_storeu_ps(p, v);
+            }
+
+            static AVS_FORCEINLINE vec min(vec a, vec b)
+            {
+                return _mm_min_ps(a, b);
+            }
+
+            static AVS_FORCEINLINE vec max(vec a, vec b)
+            {
+                return _mm_max_ps(a, b);
+            }
+        };
+#endif
+
+        template<typename L, network_op Op>
+        AVS_FORCEINLINE void network_step(typename L::vec* v)
+        {
+            if constexpr (Op.kind == 0)
+            {
+                const typename L::vec lo{L::min(v[Op.lo], v[Op.hi])};
+                v[Op.hi] = L::max(v[Op.lo], v[Op.hi]);
+                v[Op.lo] = lo;
+            }
+            else if constexpr (Op.kind == 1)
+                v[Op.lo] = L::min(v[Op.lo], v[Op.hi]);
+            else
+                v[Op.hi] = L::max(v[Op.lo], v[Op.hi]);
+        }
+
+        // Returns element Rank of the sorted v[0..N), overwriting v. Fully unrolled.
+        template<typename L, int N, int Rank>
+        AVS_FORCEINLINE typename L::vec select_rank(typename L::vec* v)
+        {
+            constexpr const selection_network& net{rank_network<N, Rank>};
+
+            [&]<std::size_t... I>(std::index_sequence<I...>) {
+                (network_step<L, net.ops[I]>(v), ...);
+            }(std::make_index_sequence<static_cast<std::size_t>(net.count)>{});
+
+            return v[Rank];
+        }
+
+        // Rank filter over the (2R + 1)^2 neighbourhood; Rank indexes the sorted neighbourhood.
+        template<typename T, int R, int Rank>
+        AVS_FORCEINLINE void rank_filter_rows(plane_view<T> dst, plane_view<const T> src, border_mode border)
+        {
+            constexpr int D{2 * R + 1};
+            constexpr int N{D * D};
+            const int width{src.width};
+
+            const auto scalar_at{[&](const T* const (&rows)[D], T* d, int x) {
+                using S = scalar_lanes<T>;
+                T v[N];
+                for (int dy{0}; dy < D; ++dy)
+                {
+                    for (int dx{0}; dx < D; ++dx)
+                        v[dy * D + dx] = rows[dy][border_index(x + dx - R, width, border)];
+                }
+                d[x] = select_rank<S, N, Rank>(v);
+            }};
+
+            for (int y{0}; y < src.height; ++y)
+            {
+                const T* rows[D];
+                for (int dy{0}; dy < D; ++dy)
+                    rows[dy] = src.row(border_index(y + dy - R, src.height, border));
+
+                T* d{dst.row(y)};
+                int x{0};
+
+                for (; x < std::min(R, width); ++x)
+                    scalar_at(rows, d, x);
+
+#if AVS_HELPERS_RANK_SSE2
+                using L = sse2_lanes<T>;
+                for (; x + L::lanes + R <= width; x += L::lanes)
+                {
+                    typename L::vec v[N];
+                    for (int dy{0}; dy < D; ++dy)
+                    {
+                        for (int dx{0}; dx < D; ++dx)
+                            v[dy * D + dx] = L::load(rows[dy] + x + dx - R);
+                    }
+                    L::store(d + x, select_rank<L, N, Rank>(v));
+                }
+#endif
+                for (; x < width; ++x)
+                    scalar_at(rows, d, x);
+            }
+        }
+
+        template<typename T, int N>
+        AVS_FORCEINLINE void temporal_median_rows(plane_view<T> dst, const plane_view<const T>* src)
+        {
+            for (int y{0}; y < dst.height; ++y)
+            {
+                const T* rows[N];
+                for (int k{0}; k < N; ++k)
+                    rows[k] = src[k].row(y);
+
+                T* d{dst.row(y)};
+                int x{0};
+#if AVS_HELPERS_RANK_SSE2
+                using L = sse2_lanes<T>;
+                for (; x + L::lanes <= dst.width; x += L::lanes)
+                {
+                    typename L::vec v[N];
+                    for (int k{0}; k < N; ++k)
+                        v[k] = L::load(rows[k] + x);
+                    L::store(d + x, select_rank<L, N, N / 2>(v));
+                }
+#endif
+                for (; x < dst.width; ++x)
+                {
+                    T v[N];
+                    for (int k{0}; k < N; ++k)
+                        v[k] = rows[k][x];
+                    d[x] = select_rank<scalar_lanes<T>, N, N / 2>(v);
+                }
+            }
+        }
+
+        enum class rank_kind
+        {
+            min,
+            median,
+            max
+        };
+
+        template<typename T>
+        AVS_FORCEINLINE bool rank_dispatch(plane_view<T> dst, plane_view<const T> src, int radius, rank_kind kind, border_mode border)
+        {
+            if (dst.width != src.width || dst.height != src.height)
+                return false;
+
+            switch (radius * 3 + static_cast<int>(kind))
+            {
+            case 1 * 3 + static_cast<int>(rank_kind::min):
+                rank_filter_rows<T, 1, 0>(dst, src, border);
+                return true;
+            case 1 * 3 + static_cast<int>(rank_kind::median):
+                rank_filter_rows<T, 1, 4>(dst, src, border);
+                return true;
+            case 1 * 3 + static_cast<int>(rank_kind::max):
+                rank_filter_rows<T, 1, 8>(dst, src, border);
+                return true;
+            case 2 * 3 + static_cast<int>(rank_kind::min):
+                rank_filter_rows<T, 2, 0>(dst, src, border);
+                return true;
+            case 2 * 3 + static_cast<int>(rank_kind::median):
+                rank_filter_rows<T, 2, 12>(dst, src, border);
+                return true;
+            case 2 * 3 + static_cast<int>(rank_kind::max):
+                rank_filter_rows<T, 2, 24>(dst, src, border);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        template<typename T>
+        AVS_FORCEINLINE bool temporal_median_dispatch(plane_view<T> dst, const plane_view<const T>* src, int count)
+        {
+            switch (count)
+            {
+            case 3:
+                temporal_median_rows<T, 3>(dst, src);
+                return true;
+            case 5:
+                temporal_median_rows<T, 5>(dst, src);
+                return true;
+            case 7:
+                temporal_median_rows<T, 7>(dst, src);
+                return true;
+            case 9:
+                temporal_median_rows<T, 9>(dst, src);
+                return true;
+            default:
+                return false;
+            }
+        }
+    } // namespace detail
+
+    /**
+     * @brief Median of the 3x3 (radius 1) or 5x5 (radius 2) neighbourhood of each sample.
+     * Uses selection networks (Batcher's merge sort pruned to the median output) evaluated on 16/8/4 samples
+     * at a time with SSE2 min/max; border samples use the same network on scalars.
+     * @param dst Plane of the size of src; must not overlap src.
+     * @return false if the radius is not 1 or 2 or the sizes do not match.
+     */
+    AVS_HELPERS_KERNEL inline bool median_filter_plane(
+        plane_view<std::uint8_t> dst, plane_view<const std::uint8_t> src, int radius, border_mode border = border_mode::replicate)
+    {
+        return detail::rank_dispatch(dst, src, radius, detail::rank_kind::median, border);
+    }
+
+    AVS_HELPERS_KERNEL inline bool median_filter_plane(
+        plane_view<std::uint16_t> dst, plane_view<const std::uint16_t> src, int radius, border_mode border = border_mode::replicate)
+    {
+        return detail::rank_dispatch(dst, src, radius, detail::rank_kind::median, border);
+    }
+
+    AVS_HELPERS_KERNEL inline bool median_filter_plane(
+        plane_view<float> dst, plane_view<const float> src, int radius, border_mode border = border_mode::replicate)
+    {
+        return detail::rank_dispatch(dst, src, radius, detail::rank_kind::median, border);
+    }
+
+    /**
+     * @brief Minimum (erosion) of the 3x3 or 5x5 neighbourhood of each sample (see median_filter_plane).
+     */
+    AVS_HELPERS_KERNEL inline bool min_filter_plane(
+        plane_view<std::uint8_t> dst, plane_view<const std::uint8_t> src, int radius, border_mode border = border_mode::replicate)
+    {
+        return detail::rank_dispatch(dst, src, radius, detail::rank_kind::min, border);
+    }
+
+    AVS_HELPERS_KERNEL inline bool min_filter_plane(
+        plane_view<std::uint16_t> dst, plane_view<const std::uint16_t> src, int radius, border_mode border = border_mode::replicate)
+    {
+        return detail::rank_dispatch(dst, src, radius, detail::rank_kind::min, border);
+    }
+
+    AVS_HELPERS_KERNEL inline bool min_filter_plane(
+        plane_view<float> dst, plane_view<const float> src, int radius, border_mode border = border_mode::replicate)
+    {
+        return detail::rank_dispatch(dst, src, radius, detail::rank_kind::min, border);
+    }
+
+    /**
+     * @brief Maximum (dilation) of the 3x3 or 5x5 neighbourhood of each sample (see median_filter_plane).
+     */
+    AVS_HELPERS_KERNEL inline bool max_filter_plane(
+        plane_view<std::uint8_t> dst, plane_view<const std::uint8_t> src, int radius, border_mode border = border_mode::replicate)
+    {
+        return detail::rank_dispatch(dst, src, radius, detail::rank_kind::max, border);
+    }
+
+    AVS_HELPERS_KERNEL inline bool max_filter_plane(
+        plane_view<std::uint16_t> dst, plane_view<const std::uint16_t> src, int radius, border_mode border = border_mode::replicate)
+    {
+        return detail::rank_dispatch(dst, src, radius, detail::rank_kind::max, border);
+    }
+
+    AVS_HELPERS_KERNEL inline bool max_filter_plane(
+        plane_view<float> dst, plane_view<const float> src, int radius, border_mode border = border_mode::replicate)
+    {
+        return detail::rank_dispatch(dst, src, radius, detail::rank_kind::max, border);
+    }
+
+    /**
+     * @brief Per-sample median of the same plane of count frames (3, 5, 7 or 9), e.g. frames n - 2..n + 2.
+     * @param src count planes of the size of dst.
+     * @return false if count is not supported.
+     */
+    AVS_HELPERS_KERNEL inline bool temporal_median_plane(plane_view<std::uint8_t> dst, const plane_view<const std::uint8_t>* src, int count)
+    {
+        return detail::temporal_median_dispatch(dst, src, count);
+    }
+
+    AVS_HELPERS_KERNEL inline bool temporal_median_plane(plane_view<std::uint16_t> dst, const plane_view<const std::uint16_t>* src, int count)
+    {
+        return detail::temporal_median_dispatch(dst, src, count);
+    }
+
+    AVS_HELPERS_KERNEL inline bool temporal_median_plane(plane_view<float> dst, const plane_view<const float>* src, int count)
+    {
+        return detail::temporal_median_dispatch(dst, src, count);
+    }
+} // namespace avs_helpers
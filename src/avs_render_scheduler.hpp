@@ -0,0 +1,345 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "avs_c_api_loader.hpp"
+
+namespace avs_helpers
+{
+    /**
+     * @brief Renders many independent scripts at once, each in its own script environment, on a bounded set of
+     * worker threads.
+     * A job is served by one worker at a time (its environment is not shared between threads) for
+     * frames_per_slice frames, then goes to the back of the run queue, so all open jobs advance at the same rate.
+     * At most max_open_jobs environments exist at once; each gets memory_max_mb / max_open_jobs through
+     * avs_set_memory_max, which bounds the frame caches of the whole process.
+     */
+    class render_scheduler
+    {
+    public:
+        struct progress
+        {
+            std::size_t job;
+            int frames_done;
+            int frames_total;
+            bool finished;
+            /** Empty unless the job failed. */
+            std::string_view error;
+        };
+
+        /**
+         * @brief Receives the rendered frames of a job, in order, on a worker thread.
+         * @return false to abort the job.
+         */
+        using frame_sink = std::function<bool(std::size_t job, int n, const AVS_VideoFrame* frame)>;
+        using progress_callback = std::function<void(const progress&)>;
+
+        struct job
+        {
+            /** Script path, or script text when is_text is true. */
+            std::string script;
+            bool is_text{false};
+            int first_frame{0};
+            /** Last frame to render; negative for the end of the clip. */
+            int last_frame{-1};
+            frame_sink sink;
+            progress_callback on_progress;
+        };
+
+        struct config
+        {
+            int interface_version{10};
+            int bugfix_version{0};
+            std::span<const std::string_view> required_functions;
+            /** Worker threads; 0 for std::thread::hardware_concurrency(). */
+            unsigned workers{0};
+            /** Environments open at once; 0 for the number of workers. */
+            unsigned max_open_jobs{0};
+            /** Memory cap in MiB shared by all open environments; 0 to keep the Avisynth+ default. */
+            int memory_max_mb{0};
+            /** Frames rendered before a worker moves to the next job. */
+            int frames_per_slice{1};
+        };
+
+        render_scheduler() = default;
+
+        explicit render_scheduler(config cfg)
+            : cfg_(std::move(cfg))
+        {
+        }
+
+        render_scheduler(const render_scheduler&) = delete;
+        render_scheduler& operator=(const render_scheduler&) = delete;
+
+        /**
+         * @brief Queues a job for the next run().
+         * @return The job index passed to its callbacks.
+         */
+        std::size_t add(job j)
+        {
+            job_state& js{jobs_.emplace_back()};
+            js.spec = std::move(j);
+            return jobs_.size() - 1;
+        }
+
+        /**
+         * @brief Renders all queued jobs and blocks until they are finished or cancelled.
+         * @return false if any job failed (see last_error() and the progress callbacks).
+         */
+        bool run()
+        {
+            const unsigned workers{(cfg_.workers) ? cfg_.workers : std::max(1u, std::thread::hardware_concurrency())};
+            max_open_ = (cfg_.max_open_jobs) ? cfg_.max_open_jobs : workers;
+            open_ = 0;
+            next_pending_ = 0;
+            busy_ = 0;
+            failed_ = false;
+            cancel_.store(false, std::memory_order_relaxed);
+            runnable_.clear();
+            {
+                std::lock_guard lock{mutex_};
+                last_error_.clear();
+            }
+
+            // Keeps the library loaded while job environments come and go.
+            keeper_ = avisynth_c_api_loader::create_script_environment(
+                cfg_.interface_version, cfg_.bugfix_version, cfg_.required_functions);
+            if (!keeper_)
+            {
+                std::lock_guard lock{mutex_};
+                last_error_ = avisynth_c_api_loader::get_last_error();
+                return false;
+            }
+
+            std::vector<std::thread> threads;
+            threads.reserve(workers);
+            for (unsigned i{0}; i < workers; ++i)
+                threads.emplace_back([this] { worker_loop(); });
+
+            for (std::thread& t : threads)
+                t.join();
+
+            g_avs_api->avs_delete_script_environment(std::exchange(keeper_, nullptr));
+            jobs_.clear();
+
+            return !failed_;
+        }
+
+        /**
+         * @brief Stops run() after the frames in flight. Callable from any thread, including callbacks.
+         */
+        void cancel() noexcept
+        {
+            // No lock: a worker that misses this wakeup is waiting for a busy job, whose completion wakes it again.
+            cancel_.store(true, std::memory_order_relaxed);
+            wake_.notify_all();
+        }
+
+        /**
+         * @brief Gets the first job error of the current or last run(). Empty if there was no error.
+         */
+        std::string last_error() const
+        {
+            std::lock_guard lock{mutex_};
+            return last_error_;
+        }
+
+    private:
+        struct job_state
+        {
+            job spec;
+            AVS_ScriptEnvironment* env{};
+            avs_clip_ptr clip;
+            int next{};
+            int last{-1};
+            int done{};
+            std::string error;
+        };
+
+        // Called by the worker that first picks the job, without mutex_.
+        bool open_job(std::size_t index)
+        {
+            job_state& js{jobs_[index]};
+
+            {
+                // The loader's reference count is not thread-safe.
+                std::lock_guard lock{loader_mutex_};
+                js.env = avisynth_c_api_loader::create_script_environment(
+                    cfg_.interface_version, cfg_.bugfix_version, cfg_.required_functions);
+                // Copied under the lock: another job's creation may overwrite the message.
+                if (!js.env)
+                    js.error = avisynth_c_api_loader::get_last_error();
+            }
+            if (!js.env)
+                return false;
+
+            if (cfg_.memory_max_mb > 0)
+                g_avs_api->avs_set_memory_max(js.env, std::max(1, cfg_.memory_max_mb / static_cast<int>(max_open_)));
+
+            avs_value_owner result{g_avs_api->avs_invoke(
+                js.env, (js.spec.is_text) ? "Eval" : "Import", avs_new_value_string(js.spec.script.c_str()), nullptr)};
+            if (avs_is_error(result.get()))
+                js.error = avs_as_error(result.get());
+            else if (!avs_is_clip(result.get()))
+                js.error = "render_scheduler: the script did not return a clip.";
+            else
+            {
+                js.clip.reset(g_avs_api->avs_take_clip(result.get(), js.env));
+                const int num_frames{g_avs_api->avs_get_video_info(js.clip.get())->num_frames};
+                js.next = std::max(0, js.spec.first_frame);
+                js.last = (js.spec.last_frame < 0) ? num_frames - 1 : std::min(js.spec.last_frame, num_frames - 1);
+            }
+
+            return js.error.empty();
+        }
+
+        // Called with mutex_ held.
+        void close_job(std::size_t index)
+        {
+            job_state& js{jobs_[index]};
+
+            js.clip.reset();
+            if (js.env)
+            {
+                std::lock_guard loader_lock{loader_mutex_};
+                g_avs_api->avs_delete_script_environment(std::exchange(js.env, nullptr));
+            }
+
+            if (!js.error.empty())
+            {
+                failed_ = true;
+                if (last_error_.empty())
+                    last_error_ = js.error;
+            }
+
+            --open_;
+        }
+
+        // Called with mutex_ held. Queues pending jobs while there is room; the worker that picks one opens it.
+        void admit_jobs()
+        {
+            while (open_ < max_open_ && next_pending_ < jobs_.size() && !cancel_.load(std::memory_order_relaxed))
+            {
+                runnable_.push_back(next_pending_++);
+                ++open_;
+            }
+        }
+
+        void report(std::size_t index, bool finished)
+        {
+            job_state& js{jobs_[index]};
+            if (js.spec.on_progress)
+                js.spec.on_progress({index, js.done, std::max(0, js.last - std::max(0, js.spec.first_frame) + 1), finished, js.error});
+        }
+
+        void worker_loop()
+        {
+            std::unique_lock lock{mutex_};
+
+            for (;;)
+            {
+                admit_jobs();
+
+                wake_.wait(lock, [this] {
+                    return !runnable_.empty() || cancel_.load(std::memory_order_relaxed) ||
+                           (busy_ == 0 && open_ == 0 && next_pending_ == jobs_.size());
+                });
+
+                if (runnable_.empty() || cancel_.load(std::memory_order_relaxed))
+                {
+                    if (cancel_.load(std::memory_order_relaxed) && busy_ == 0)
+                    {
+                        // Jobs waiting in the run queue are closed by whoever sees the cancellation first.
+                        while (!runnable_.empty())
+                        {
+                            const std::size_t index{runnable_.front()};
+                            runnable_.pop_front();
+                            close_job(index);
+                            report(index, true);
+                        }
+                    }
+                    wake_.notify_all();
+                    return;
+                }
+
+                const std::size_t index{runnable_.front()};
+                runnable_.pop_front();
+                ++busy_;
+                lock.unlock();
+
+                job_state& js{jobs_[index]};
+                bool finished{false};
+                if (!js.clip)
+                    finished = !open_job(index);
+
+                for (int i{0}; !finished && i < std::max(1, cfg_.frames_per_slice); ++i)
+                {
+                    if (js.next > js.last || cancel_.load(std::memory_order_relaxed))
+                    {
+                        finished = true;
+                        break;
+                    }
+
+                    const int n{js.next++};
+                    avs_video_frame_ptr frame{g_avs_api->avs_get_frame(js.clip.get(), n)};
+                    if (!frame)
+                    {
+                        const char* error{g_avs_api->avs_clip_get_error(js.clip.get())};
+                        js.error = (error) ? error : "render_scheduler: avs_get_frame failed.";
+                        finished = true;
+                        break;
+                    }
+
+                    if (js.spec.sink && !js.spec.sink(index, n, frame.get()))
+                    {
+                        finished = true;
+                        break;
+                    }
+
+                    ++js.done;
+                }
+                finished = finished || js.next > js.last;
+
+                report(index, finished);
+
+                lock.lock();
+                --busy_;
+                if (finished)
+                    close_job(index);
+                else
+                    runnable_.push_back(index);
+                wake_.notify_all();
+            }
+        }
+
+        config cfg_;
+        std::deque<job_state> jobs_;
+        std::deque<std::size_t> runnable_;
+        AVS_ScriptEnvironment* keeper_{};
+        std::size_t next_pending_{};
+        unsigned max_open_{};
+        unsigned open_{};
+        unsigned busy_{};
+        bool failed_{};
+        std::atomic<bool> cancel_{};
+        std::string last_error_;
+        mutable std::mutex mutex_;
+        std::mutex loader_mutex_;
+        std::condition_variable wake_;
+    };
+} // namespace avs_helpers
@@ -0,0 +1,490 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include "avs_cpu_dispatch.hpp"
+#include "avs_frame_view.hpp"
+#include "avs_thread_pool.hpp"
+
+// The SSSE3 row kernels are inlined when the build targets SSSE3. Otherwise (x86-64 baseline builds, including the
+// baseline clone of AVS_HELPERS_KERNEL) they are compiled separately for SSSE3 and selected at run time.
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define AVS_HELPERS_RGB_SSSE3 1
+#define AVS_HELPERS_RGB_SSSE3_RUNTIME 0
+#define AVS_HELPERS_RGB_SSSE3_FUNC AVS_FORCEINLINE
+#define AVS_HELPERS_RGB_SSSE3_INLINE AVS_FORCEINLINE
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#include <tmmintrin.h>
+#define AVS_HELPERS_RGB_SSSE3 1
+#define AVS_HELPERS_RGB_SSSE3_RUNTIME 1
+#define AVS_HELPERS_RGB_SSSE3_FUNC __attribute__((target("ssse3"))) inline
+#define AVS_HELPERS_RGB_SSSE3_INLINE __attribute__((target("ssse3"))) AVS_FORCEINLINE
+#elif defined(_M_X64)
+#include <intrin.h>
+#include <tmmintrin.h>
+#define AVS_HELPERS_RGB_SSSE3 1
+#define AVS_HELPERS_RGB_SSSE3_RUNTIME 1
+#define AVS_HELPERS_RGB_SSSE3_FUNC inline
+#define AVS_HELPERS_RGB_SSSE3_INLINE AVS_FORCEINLINE
+#else
+#define AVS_HELPERS_RGB_SSSE3 0
+#define AVS_HELPERS_RGB_SSSE3_RUNTIME 0
+#endif
+
+namespace avs_helpers
+{
+    namespace detail
+    {
+        // Packed RGB stores B, G, R(, A) per pixel; a 16-byte vector holds N = 16 / E samples of one plane, so the
+        // N pixels of a step span C vectors. The masks below are pshufb controls (-128 clears the byte).
+
+        // Gathers channel c of the step's pixels from packed vector k.
+        constexpr std::array<std::int8_t, 16> rgb_gather_mask(int C, int E, int c, int k)
+        {
+            std::array<std::int8_t, 16> m{};
+            for (int j{0}; j < 16; ++j)
+            {
+                const int src{(j / E * C + c) * E + j % E - 16 * k};
+                m[j] = static_cast<std::int8_t>((src >= 0 && src < 16) ? src : -128);
+            }
+
+            return m;
+        }
+
+        // Places channel c of the step's pixels into packed vector k.
+        constexpr std::array<std::int8_t, 16> rgb_scatter_mask(int C, int E, int c, int k)
+        {
+            std::array<std::int8_t, 16> m{};
+            for (int j{0}; j < 16; ++j)
+            {
+                const int byte{16 * k + j};
+                const int offset{byte % (C * E)};
+                m[j] = static_cast<std::int8_t>((offset / E == c) ? byte / (C * E) * E + offset % E : -128);
+            }
+
+            return m;
+        }
+
+        constexpr bool rgb_mask_used(const std::array<std::int8_t, 16>& m)
+        {
+            return std::any_of(m.begin(), m.end(), [](std::int8_t v) { return v >= 0; });
+        }
+
+        // 4 channels: groups the channels of one packed vector into 32-bit lanes (B B.. G G.. R R.. A A..), so that a
+        // 4x4 transpose of 32-bit lanes across the step's 4 vectors yields the planes.
+        constexpr std::array<std::int8_t, 16> rgb_group_mask(int E)
+        {
+            std::array<std::int8_t, 16> m{};
+            for (int j{0}; j < 16; ++j)
+                m[j] = static_cast<std::int8_t>((j % 4 / E * 4 + j / 4) * E + j % E);
+
+            return m;
+        }
+
+        constexpr std::array<std::int8_t, 16> rgb_ungroup_mask(int E)
+        {
+            const auto group{rgb_group_mask(E)};
+            std::array<std::int8_t, 16> m{};
+            for (int j{0}; j < 16; ++j)
+                m[group[j]] = static_cast<std::int8_t>(j);
+
+            return m;
+        }
+
+#if AVS_HELPERS_RGB_SSSE3
+        // Whether the SSSE3 row kernels can run. Like the target_clones resolver, the runtime check looks at the CPU
+        // only (not at SetMaxCPU).
+        inline bool rgb_ssse3_supported() noexcept
+        {
+#if !AVS_HELPERS_RGB_SSSE3_RUNTIME
+            return true;
+#elif defined(_MSC_VER)
+            static const bool supported{[] {
+                int info[4];
+                __cpuid(info, 1);
+                return (info[2] & (1 << 9)) != 0;
+            }()};
+            return supported;
+#else
+            static const bool supported{[] {
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("ssse3") != 0;
+            }()};
+            return supported;
+#endif
+        }
+
+        template<int C, int E, int c, int k>
+        AVS_HELPERS_RGB_SSSE3_INLINE __m128i rgb_gather(const __m128i (&v)[C])
+        {
+            static constexpr auto mask{rgb_gather_mask(C, E, c, k)};
+            if constexpr (rgb_mask_used(mask))
+                return _mm_shuffle_epi8(v[k], _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask.data())));
+            else
+                return _mm_setzero_si128();
+        }
+
+        template<int C, int E, int c, int k>
+        AVS_HELPERS_RGB_SSSE3_INLINE __m128i rgb_scatter(const __m128i (&p)[4])
+        {
+            static constexpr auto mask{rgb_scatter_mask(C, E, c, k)};
+            if constexpr (rgb_mask_used(mask))
+                return _mm_shuffle_epi8(p[c], _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask.data())));
+            else
+                return _mm_setzero_si128();
+        }
+
+        AVS_HELPERS_RGB_SSSE3_INLINE void transpose_4x32(__m128i (&v)[4])
+        {
+            const __m128i t0{_mm_unpacklo_epi32(v[0], v[1])};
+            const __m128i t1{_mm_unpackhi_epi32(v[0], v[1])};
+            const __m128i t2{_mm_unpacklo_epi32(v[2], v[3])};
+            const __m128i t3{_mm_unpackhi_epi32(v[2], v[3])};
+            v[0] = _mm_unpacklo_epi64(t0, t2);
+            v[1] = _mm_unpackhi_epi64(t0, t2);
+            v[2] = _mm_unpacklo_epi64(t1, t3);
+            v[3] = _mm_unpackhi_epi64(t1, t3);
+        }
+
+        // Returns the first pixel not processed.
+        template<typename T, int C, bool A>
+        AVS_HELPERS_RGB_SSSE3_FUNC int deinterleave_rgb_row_ssse3(const T* s, T* g, T* b, T* r, T* a, int width)
+        {
+            constexpr int E{sizeof(T)};
+            constexpr int N{16 / E};
+            const auto store{[](T* dst, __m128i v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), v); }};
+            const __m128i opaque{_mm_set1_epi8(-1)};
+
+            int x{0};
+            if constexpr (C == 4)
+            {
+                static constexpr auto group{rgb_group_mask(E)};
+                const __m128i mask{_mm_loadu_si128(reinterpret_cast<const __m128i*>(group.data()))};
+
+                for (; x + N <= width; x += N)
+                {
+                    __m128i v[4];
+                    for (int k{0}; k < 4; ++k)
+                        v[k] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + x * C) + k), mask);
+                    transpose_4x32(v);
+
+                    store(b + x, v[0]);
+                    store(g + x, v[1]);
+                    store(r + x, v[2]);
+                    if constexpr (A)
+                        store(a + x, v[3]);
+                }
+            }
+            else
+            {
+                for (; x + N <= width; x += N)
+                {
+                    __m128i v[3];
+                    for (int k{0}; k < 3; ++k)
+                        v[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + x * C) + k);
+
+                    store(b + x, _mm_or_si128(_mm_or_si128(rgb_gather<3, E, 0, 0>(v), rgb_gather<3, E, 0, 1>(v)), rgb_gather<3, E, 0, 2>(v)));
+                    store(g + x, _mm_or_si128(_mm_or_si128(rgb_gather<3, E, 1, 0>(v), rgb_gather<3, E, 1, 1>(v)), rgb_gather<3, E, 1, 2>(v)));
+                    store(r + x, _mm_or_si128(_mm_or_si128(rgb_gather<3, E, 2, 0>(v), rgb_gather<3, E, 2, 1>(v)), rgb_gather<3, E, 2, 2>(v)));
+                    if constexpr (A)
+                        store(a + x, opaque);
+                }
+            }
+
+            return x;
+        }
+
+        template<typename T, int C, bool A>
+        AVS_HELPERS_RGB_SSSE3_FUNC int interleave_rgb_row_ssse3(T* d, const T* g, const T* b, const T* r, const T* a, int width)
+        {
+            constexpr int E{sizeof(T)};
+            constexpr int N{16 / E};
+            const auto load{[](const T* src) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)); }};
+            const __m128i opaque{_mm_set1_epi8(-1)};
+
+            int x{0};
+            for (; x + N <= width; x += N)
+            {
+                __m128i p[4]{load(b + x), load(g + x), load(r + x), opaque};
+                __m128i* out{reinterpret_cast<__m128i*>(d + x * C)};
+
+                if constexpr (C == 4)
+                {
+                    static constexpr auto ungroup{rgb_ungroup_mask(E)};
+                    const __m128i mask{_mm_loadu_si128(reinterpret_cast<const __m128i*>(ungroup.data()))};
+
+                    if constexpr (A)
+                        p[3] = load(a + x);
+                    transpose_4x32(p);
+                    for (int k{0}; k < 4; ++k)
+                        _mm_storeu_si128(out + k, _mm_shuffle_epi8(p[k], mask));
+                }
+                else
+                {
+                    _mm_storeu_si128(out, _mm_or_si128(_mm_or_si128(rgb_scatter<3, E, 0, 0>(p), rgb_scatter<3, E, 1, 0>(p)), rgb_scatter<3, E, 2, 0>(p)));
+                    _mm_storeu_si128(
+                        out + 1, _mm_or_si128(_mm_or_si128(rgb_scatter<3, E, 0, 1>(p), rgb_scatter<3, E, 1, 1>(p)), rgb_scatter<3, E, 2, 1>(p)));
+                    _mm_storeu_si128(
+                        out + 2, _mm_or_si128(_mm_or_si128(rgb_scatter<3, E, 0, 2>(p), rgb_scatter<3, E, 1, 2>(p)), rgb_scatter<3, E, 2, 2>(p)));
+                }
+            }
+
+            return x;
+        }
+#endif
+
+        // packed -> G, B, R(, A). A: the alpha plane is written (from the packed alpha, or opaque for 3 channels).
+        template<typename T, int C, bool A>
+        AVS_FORCEINLINE void deinterleave_rgb_rows(
+            plane_view<T> g, plane_view<T> b, plane_view<T> r, plane_view<T> a, plane_view<const T> packed)
+        {
+            constexpr T opaque{std::numeric_limits<T>::max()};
+#if AVS_HELPERS_RGB_SSSE3
+            const bool ssse3{rgb_ssse3_supported()};
+#endif
+
+            for (int y{0}; y < g.height; ++y)
+            {
+                const T* s{packed.row(y)};
+                T* pg{g.row(y)};
+                T* pb{b.row(y)};
+                T* pr{r.row(y)};
+                T* pa{(A) ? a.row(y) : nullptr};
+
+                int x{0};
+#if AVS_HELPERS_RGB_SSSE3
+                if (ssse3)
+                    x = deinterleave_rgb_row_ssse3<T, C, A>(s, pg, pb, pr, pa, g.width);
+#endif
+                // Tail and fallback. Compilers do not turn this strided loop into shuffles at -O2.
+                for (; x < g.width; ++x)
+                {
+                    pb[x] = s[x * C];
+                    pg[x] = s[x * C + 1];
+                    pr[x] = s[x * C + 2];
+                    if constexpr (A)
+                        pa[x] = (C == 4) ? s[x * C + 3] : opaque;
+                }
+            }
+        }
+
+        // G, B, R(, A) -> packed. A: the packed alpha comes from the alpha plane, otherwise it is opaque.
+        template<typename T, int C, bool A>
+        AVS_FORCEINLINE void interleave_rgb_rows(
+            plane_view<T> packed, plane_view<const T> g, plane_view<const T> b, plane_view<const T> r, plane_view<const T> a)
+        {
+            constexpr T opaque{std::numeric_limits<T>::max()};
+#if AVS_HELPERS_RGB_SSSE3
+            const bool ssse3{rgb_ssse3_supported()};
+#endif
+
+            for (int y{0}; y < g.height; ++y)
+            {
+                T* d{packed.row(y)};
+                const T* pg{g.row(y)};
+                const T* pb{b.row(y)};
+                const T* pr{r.row(y)};
+                const T* pa{(A) ? a.row(y) : nullptr};
+
+                int x{0};
+#if AVS_HELPERS_RGB_SSSE3
+                if (ssse3)
+                    x = interleave_rgb_row_ssse3<T, C, A>(d, pg, pb, pr, pa, g.width);
+#endif
+                for (; x < g.width; ++x)
+                {
+                    d[x * C] = pb[x];
+                    d[x * C + 1] = pg[x];
+                    d[x * C + 2] = pr[x];
+                    if constexpr (C == 4)
+                        d[x * C + 3] = (A) ? pa[x] : opaque;
+                }
+            }
+        }
+
+        template<typename T>
+        AVS_FORCEINLINE bool deinterleave_rgb_dispatch(
+            plane_view<T> g, plane_view<T> b, plane_view<T> r, plane_view<T> a, plane_view<const T> packed, int channels)
+        {
+            switch ((channels << 1) | (a.data != nullptr))
+            {
+            case (3 << 1) | 0:
+                deinterleave_rgb_rows<T, 3, false>(g, b, r, a, packed);
+                return true;
+            case (3 << 1) | 1:
+                deinterleave_rgb_rows<T, 3, true>(g, b, r, a, packed);
+                return true;
+            case (4 << 1) | 0:
+                deinterleave_rgb_rows<T, 4, false>(g, b, r, a, packed);
+                return true;
+            case (4 << 1) | 1:
+                deinterleave_rgb_rows<T, 4, true>(g, b, r, a, packed);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        template<typename T>
+        AVS_FORCEINLINE bool interleave_rgb_dispatch(
+            plane_view<T> packed, plane_view<const T> g, plane_view<const T> b, plane_view<const T> r, plane_view<const T> a, int channels)
+        {
+            switch ((channels << 1) | (a.data != nullptr))
+            {
+            case (3 << 1) | 0:
+            case (3 << 1) | 1:
+                interleave_rgb_rows<T, 3, false>(packed, g, b, r, a);
+                return true;
+            case (4 << 1) | 0:
+                interleave_rgb_rows<T, 4, false>(packed, g, b, r, a);
+                return true;
+            case (4 << 1) | 1:
+                interleave_rgb_rows<T, 4, true>(packed, g, b, r, a);
+                return true;
+            default:
+                return false;
+            }
+        }
+    } // namespace detail
+
+    /**
+     * @brief Splits packed RGB rows (B, G, R(, A) per pixel) into planar G, B, R(, A) rows of the same bit depth.
+     * Rows are taken in the order of the views; pass packed.flipped() for display order (packed RGB is stored
+     * bottom-up).
+     * @param a Alpha plane, or an empty view (data nullptr) to drop the packed alpha. With 3 channels it is filled
+     * with the maximum value.
+     * @param packed Packed rows; width is in samples (pixels * channels).
+     * @param channels 3 (RGB24/RGB48) or 4 (RGB32/RGB64).
+     * @return false if channels is not 3 or 4.
+     */
+    AVS_HELPERS_KERNEL inline bool deinterleave_rgb(plane_view<std::uint8_t> g, plane_view<std::uint8_t> b, plane_view<std::uint8_t> r,
+        plane_view<std::uint8_t> a, plane_view<const std::uint8_t> packed, int channels)
+    {
+        return detail::deinterleave_rgb_dispatch(g, b, r, a, packed, channels);
+    }
+
+    AVS_HELPERS_KERNEL inline bool deinterleave_rgb(plane_view<std::uint16_t> g, plane_view<std::uint16_t> b, plane_view<std::uint16_t> r,
+        plane_view<std::uint16_t> a, plane_view<const std::uint16_t> packed, int channels)
+    {
+        return detail::deinterleave_rgb_dispatch(g, b, r, a, packed, channels);
+    }
+
+    /**
+     * @brief Merges planar G, B, R(, A) rows into packed RGB rows (the inverse of deinterleave_rgb).
+     * @param a Alpha plane, or an empty view for an opaque packed alpha. Ignored with 3 channels.
+     * @return false if channels is not 3 or 4.
+     */
+    AVS_HELPERS_KERNEL inline bool interleave_rgb(plane_view<std::uint8_t> packed, plane_view<const std::uint8_t> g,
+        plane_view<const std::uint8_t> b, plane_view<const std::uint8_t> r, plane_view<const std::uint8_t> a, int channels)
+    {
+        return detail::interleave_rgb_dispatch(packed, g, b, r, a, channels);
+    }
+
+    AVS_HELPERS_KERNEL inline bool interleave_rgb(plane_view<std::uint16_t> packed, plane_view<const std::uint16_t> g,
+        plane_view<const std::uint16_t> b, plane_view<const std::uint16_t> r, plane_view<const std::uint16_t> a, int channels)
+    {
+        return detail::interleave_rgb_dispatch(packed, g, b, r, a, channels);
+    }
+
+    namespace detail
+    {
+        // Runs f(first_row, rows) over strips of strip_rows rows, on pool if given.
+        template<typename F>
+        void for_each_strip(int height, int strip_rows, thread_pool* pool, F&& f)
+        {
+            strip_rows = std::max(strip_rows, 1);
+            const int strips{(height + strip_rows - 1) / strip_rows};
+            const auto strip{[&](int i) { f(i * strip_rows, std::min(strip_rows, height - i * strip_rows)); }};
+
+            if (pool && strips > 1)
+                pool->parallel_for(strips, strip);
+            else
+            {
+                for (int i{0}; i < strips; ++i)
+                    strip(i);
+            }
+        }
+
+        template<typename T>
+        bool packed_to_planar_rgb(const frame_view& dst, const frame_view& src, thread_pool* pool, int strip_rows)
+        {
+            const plane_view<const T> packed{src.read<T>(0).flipped()};
+            const plane_view<T> g{dst.write<T>(0)};
+            const plane_view<T> b{dst.write<T>(1)};
+            const plane_view<T> r{dst.write<T>(2)};
+            const plane_view<T> a{(dst.num_planes == 4) ? dst.write<T>(3) : plane_view<T>{}};
+            const int channels{packed.width / g.width};
+
+            if (channels != 3 && channels != 4)
+                return false;
+
+            for_each_strip(g.height, strip_rows, pool, [&](int y, int rows) {
+                deinterleave_rgb(g.rows(y, rows), b.rows(y, rows), r.rows(y, rows), (a.data) ? a.rows(y, rows) : a, packed.rows(y, rows),
+                    channels);
+            });
+
+            return true;
+        }
+
+        template<typename T>
+        bool planar_to_packed_rgb(const frame_view& dst, const frame_view& src, thread_pool* pool, int strip_rows)
+        {
+            const plane_view<T> packed{dst.write<T>(0).flipped()};
+            const plane_view<const T> g{src.read<T>(0)};
+            const plane_view<const T> b{src.read<T>(1)};
+            const plane_view<const T> r{src.read<T>(2)};
+            const plane_view<const T> a{(src.num_planes == 4) ? src.read<T>(3) : plane_view<const T>{}};
+            const int channels{packed.width / g.width};
+
+            if (channels != 3 && channels != 4)
+                return false;
+
+            for_each_strip(g.height, strip_rows, pool, [&](int y, int rows) {
+                interleave_rgb(packed.rows(y, rows), g.rows(y, rows), b.rows(y, rows), r.rows(y, rows), (a.data) ? a.rows(y, rows) : a,
+                    channels);
+            });
+
+            return true;
+        }
+    } // namespace detail
+
+    /**
+     * @brief Converts a packed RGB24/RGB32/RGB48/RGB64 frame to planar RGB(A) of the same bit depth, in display order.
+     * RGB32/RGB64 alpha is kept if dst has an alpha plane; RGB24/RGB48 to planar RGBA gives an opaque alpha plane.
+     * @param dst Writable planar RGB(A) frame of the same size.
+     * @param src Packed RGB frame (frame_view::bottom_up).
+     * @param pool Runs strips of strip_rows rows in parallel; nullptr converts on the calling thread.
+     * @return false if the formats do not match.
+     */
+    inline bool packed_to_planar_rgb(const frame_view& dst, const frame_view& src, thread_pool* pool = nullptr, int strip_rows = 64)
+    {
+        if (!src.bottom_up || dst.num_planes < 3 || dst.bits != src.bits)
+            return false;
+
+        return (src.bits == 8) ? detail::packed_to_planar_rgb<std::uint8_t>(dst, src, pool, strip_rows)
+                               : detail::packed_to_planar_rgb<std::uint16_t>(dst, src, pool, strip_rows);
+    }
+
+    /**
+     * @brief Converts a planar RGB(A) frame to packed RGB24/RGB32/RGB48/RGB64 of the same bit depth.
+     * Packed alpha comes from the alpha plane if src has one and is opaque otherwise.
+     * @param dst Writable packed RGB frame of the same size (frame_view::bottom_up).
+     * @param pool Runs strips of strip_rows rows in parallel; nullptr converts on the calling thread.
+     * @return false if the formats do not match.
+     */
+    inline bool planar_to_packed_rgb(const frame_view& dst, const frame_view& src, thread_pool* pool = nullptr, int strip_rows = 64)
+    {
+        if (!dst.bottom_up || src.num_planes < 3 || dst.bits != src.bits)
+            return false;
+
+        return (src.bits == 8) ? detail::planar_to_packed_rgb<std::uint8_t>(dst, src, pool, strip_rows)
+                               : detail::planar_to_packed_rgb<std::uint16_t>(dst, src, pool, strip_rows);
+    }
+} // namespace avs_helpers
@@ -0,0 +1,708 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "avs_c_api_loader.hpp"
+#include "avs_mpmc_queue.hpp"
+
+namespace avs_helpers
+{
+    /**
+     * @brief Bounded lock-free single-producer/single-consumer queue.
+     * The blocking variants wait on the indices with std::atomic::wait (no mutex).
+     * @tparam T Element type (e.g. a frame number with an avs_video_frame_ptr). Must be default constructible and movable.
+     */
+    template<typename T>
+    class spsc_queue
+    {
+    public:
+        /**
+         * @param capacity Maximum number of queued elements (at least 1).
+         */
+        explicit spsc_queue(std::size_t capacity)
+            : slots_((capacity) ? capacity : 1)
+        {
+        }
+
+        spsc_queue(const spsc_queue&) = delete;
+        spsc_queue& operator=(const spsc_queue&) = delete;
+
+        /**
+         * @brief Pushes an element if there is room. Producer thread only.
+         * @return false if the queue is full (value is left untouched).
+         */
+        bool try_push(T& value)
+        {
+            const std::uint64_t tail{tail_.load(std::memory_order_relaxed)};
+            if (tail - head_.load(std::memory_order_acquire) == slots_.size())
+                return false;
+
+            slots_[tail % slots_.size()] = std::move(value);
+            tail_.store(tail + 1, std::memory_order_release);
+            tail_.notify_one();
+
+            return true;
+        }
+
+        /**
+         * @brief Pushes an element, waiting while the queue is full. Producer thread only.
+         * @param stop Checked while waiting; the wait ends when the consumer pops.
+         * @return false if stop was set before there was room.
+         */
+        bool push(T& value, const std::atomic<bool>& stop)
+        {
+            while (!try_push(value))
+            {
+                if (stop.load(std::memory_order_acquire))
+                    return false;
+
+                const std::uint64_t head{head_.load(std::memory_order_acquire)};
+                if (tail_.load(std::memory_order_relaxed) - head == slots_.size())
+                    head_.wait(head, std::memory_order_acquire);
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Pops an element if one is available. Consumer thread only.
+         * @return false if the queue is empty.
+         */
+        bool try_pop(T& value)
+        {
+            const std::uint64_t head{head_.load(std::memory_order_relaxed)};
+            if (tail_.load(std::memory_order_acquire) == head)
+                return false;
+
+            value = std::move(slots_[head % slots_.size()]);
+            head_.store(head + 1, std::memory_order_release);
+            head_.notify_one();
+
+            return true;
+        }
+
+        /**
+         * @brief Pops an element, waiting while the queue is empty. Consumer thread only.
+         */
+        void pop(T& value)
+        {
+            while (!try_pop(value))
+                tail_.wait(head_.load(std::memory_order_relaxed), std::memory_order_acquire);
+        }
+
+        std::size_t capacity() const noexcept
+        {
+            return slots_.size();
+        }
+
+    private:
+        std::vector<T> slots_;
+        alignas(cache_line_size) std::atomic<std::uint64_t> head_{};
+        alignas(cache_line_size) std::atomic<std::uint64_t> tail_{};
+    };
+
+    /**
+     * @brief Host-side reader that pulls frames of a script on a background thread.
+     * Frames are fetched in order starting at the requested frame and handed over through a bounded
+     * spsc_queue, so script evaluation overlaps with the caller's work (e.g. encoding).
+     * next() must be called from a single thread.
+     */
+    class script_reader
+    {
+    public:
+        static constexpr int default_read_ahead{8};
+
+        script_reader() = default;
+
+        ~script_reader()
+        {
+            close();
+        }
+
+        script_reader(const script_reader&) = delete;
+        script_reader& operator=(const script_reader&) = delete;
+
+        /**
+         * @brief Opens a script file (through "Import") and starts reading ahead.
+         * @param env The AVS_ScriptEnvironment pointer (e.g. from avisynth_c_api_loader::create_script_environment).
+         * @param script_path Path of the script.
+         * @param read_ahead Maximum number of frames fetched ahead of the consumer.
+         * @param first_frame Frame to start from.
+         * @return false on error (see last_error()).
+         */
+        bool open(AVS_ScriptEnvironment* env, const char* script_path, int read_ahead = default_read_ahead, int first_frame = 0)
+        {
+            close();
+
+            avs_value_owner result{g_avs_api->avs_invoke(env, "Import", avs_new_value_string(script_path), nullptr)};
+            if (avs_is_error(result.get()))
+            {
+                last_error_ = avs_as_error(result.get());
+                return false;
+            }
+            if (!avs_is_clip(result.get()))
+            {
+                last_error_ = "script_reader: the script did not return a clip.";
+                return false;
+            }
+
+            return open(avs_clip_ptr{g_avs_api->avs_take_clip(result.get(), env)}, read_ahead, first_frame);
+        }
+
+        /**
+         * @brief Starts reading ahead from an existing clip.
+         * @param clip The clip to read. The reader takes ownership.
+         * @param read_ahead Maximum number of frames fetched ahead of the consumer.
+         * @param first_frame Frame to start from.
+         * @return false on error (see last_error()).
+         */
+        bool open(avs_clip_ptr clip, int read_ahead = default_read_ahead, int first_frame = 0)
+        {
+            close();
+
+            if (!clip)
+            {
+                last_error_ = "script_reader: no clip.";
+                return false;
+            }
+
+            clip_ = std::move(clip);
+            vi_ = *g_avs_api->avs_get_video_info(clip_.get());
+            queue_ = std::make_unique<spsc_queue<item>>((read_ahead > 0) ? read_ahead : 1);
+            stop_.store(false, std::memory_order_relaxed);
+            done_ = false;
+            last_error_.clear();
+            worker_ = std::thread([this, first_frame] { read_loop(first_frame); });
+
+            return true;
+        }
+
+        /**
+         * @brief Stops the background thread and releases the clip and all queued frames.
+         */
+        void close()
+        {
+            if (worker_.joinable())
+            {
+                stop_.store(true, std::memory_order_release);
+
+                // Popping wakes a producer waiting for room. After that it can push at most one more item
+                // before it sees stop_, and a push into a full queue gives up once stop_ is set.
+                item discarded;
+                while (queue_->try_pop(discarded))
+                    discarded = {};
+
+                worker_.join();
+            }
+
+            queue_.reset();
+            clip_.reset();
+        }
+
+        /**
+         * @brief Gets the next frame, waiting for the background thread if necessary.
+         * @param frame_number Receives the number of the returned frame (optional).
+         * @return The frame, or an empty pointer at the end of the clip or on error (see last_error()).
+         */
+        avs_video_frame_ptr next(int* frame_number = nullptr)
+        {
+            if (done_ || !queue_)
+                return {};
+
+            item it;
+            queue_->pop(it);
+
+            if (!it.frame)
+            {
+                done_ = true;
+                if (it.error)
+                    last_error_ = it.error;
+
+                return {};
+            }
+
+            if (frame_number)
+                *frame_number = it.n;
+
+            return std::move(it.frame);
+        }
+
+        /**
+         * @brief Gets the video info of the opened clip.
+         */
+        const AVS_VideoInfo& video_info() const noexcept
+        {
+            return vi_;
+        }
+
+        /**
+         * @brief Gets the clip being read (owned by the reader).
+         */
+        AVS_Clip* clip() const noexcept
+        {
+            return clip_.get();
+        }
+
+        /**
+         * @brief Gets the last error message. Empty if there was no error.
+         */
+        const std::string& last_error() const noexcept
+        {
+            return last_error_;
+        }
+
+    private:
+        struct item
+        {
+            int n{};
+            avs_video_frame_ptr frame;
+            const char* error{};
+        };
+
+        void read_loop(int n)
+        {
+            for (; n < vi_.num_frames && !stop_.load(std::memory_order_acquire); ++n)
+            {
+                item it{n, avs_video_frame_ptr{g_avs_api->avs_get_frame(clip_.get(), n)}, nullptr};
+
+                if (!it.frame)
+                {
+                    it.error = g_avs_api->avs_clip_get_error(clip_.get());
+                    if (!it.error)
+                        it.error = "script_reader: avs_get_frame failed.";
+
+                    queue_->push(it, stop_);
+                    return;
+                }
+
+                if (!queue_->push(it, stop_))
+                    break;
+            }
+
+            // End marker (empty frame).
+            item end;
+            queue_->push(end, stop_);
+        }
+
+        avs_clip_ptr clip_;
+        AVS_VideoInfo vi_{};
+        std::unique_ptr<spsc_queue<item>> queue_;
+        std::thread worker_;
+        std::atomic<bool> stop_{};
+        bool done_{};
+        std::string last_error_;
+    };
+
+    /**
+     * @brief Host-side random-access reader for interactive use (scrubbing, reverse play, J/K/L).
+     * The last requests are classified as forward, reverse, scrub or random, and a background thread prefetches
+     * accordingly: along the stride for forward/reverse play (depth grows while prefetched frames are used),
+     * a small neighbourhood while scrubbing, nothing for random access. Every request replaces the prefetch plan,
+     * so frames that were planned for an old position are dropped before they are fetched; a fetch that is
+     * already running cannot be stopped and only lands in the cache. All avs_get_frame calls are made by the
+     * background thread. get() must be called from a single thread.
+     */
+    class seek_reader
+    {
+    public:
+        enum class access_pattern
+        {
+            forward,
+            reverse,
+            scrub,
+            random
+        };
+
+        struct statistics
+        {
+            std::uint64_t requests{};
+            std::uint64_t hits{};       // Requests served from the cache.
+            std::uint64_t prefetched{}; // Frames fetched speculatively.
+            std::uint64_t cancelled{};  // Planned prefetches dropped before they were fetched.
+        };
+
+        static constexpr int default_cache_frames{16};
+        static constexpr int default_max_read_ahead{8};
+
+        seek_reader() = default;
+
+        ~seek_reader()
+        {
+            close();
+        }
+
+        seek_reader(const seek_reader&) = delete;
+        seek_reader& operator=(const seek_reader&) = delete;
+
+        /**
+         * @brief Opens a script file (through "Import").
+         * @param env The AVS_ScriptEnvironment pointer.
+         * @param script_path Path of the script.
+         * @param cache_frames Frames kept around the current position (at least max_read_ahead + 1).
+         * @param max_read_ahead Maximum prefetch depth.
+         * @return false on error (see last_error()).
+         */
+        bool open(AVS_ScriptEnvironment* env, const char* script_path, int cache_frames = default_cache_frames,
+            int max_read_ahead = default_max_read_ahead)
+        {
+            close();
+
+            avs_value_owner result{g_avs_api->avs_invoke(env, "Import", avs_new_value_string(script_path), nullptr)};
+            if (avs_is_error(result.get()))
+            {
+                last_error_ = avs_as_error(result.get());
+                return false;
+            }
+            if (!avs_is_clip(result.get()))
+            {
+                last_error_ = "seek_reader: the script did not return a clip.";
+                return false;
+            }
+
+            return open(avs_clip_ptr{g_avs_api->avs_take_clip(result.get(), env)}, cache_frames, max_read_ahead);
+        }
+
+        /**
+         * @brief Starts the background thread for an existing clip.
+         * @param clip The clip to read. The reader takes ownership.
+         * @return false on error (see last_error()).
+         */
+        bool open(avs_clip_ptr clip, int cache_frames = default_cache_frames, int max_read_ahead = default_max_read_ahead)
+        {
+            close();
+
+            if (!clip)
+            {
+                last_error_ = "seek_reader: no clip.";
+                return false;
+            }
+
+            // get() clamps frame numbers to the clip, which needs at least one frame.
+            if (g_avs_api->avs_get_video_info(clip.get())->num_frames <= 0)
+            {
+                last_error_ = "seek_reader: the clip has no frames.";
+                return false;
+            }
+
+            clip_ = std::move(clip);
+            vi_ = *g_avs_api->avs_get_video_info(clip_.get());
+            max_depth_ = std::max(1, max_read_ahead);
+            cache_capacity_ = std::max(cache_frames, max_depth_ + 1);
+            depth_ = min_depth;
+            history_size_ = 0;
+            pattern_ = access_pattern::forward;
+            stats_ = {};
+            stop_ = false;
+            demand_ = -1;
+            in_flight_ = -1;
+            error_frame_ = -1;
+            error_ = nullptr;
+            last_error_.clear();
+            worker_ = std::thread([this] { fetch_loop(); });
+
+            return true;
+        }
+
+        /**
+         * @brief Stops the background thread and releases the clip and all cached frames.
+         */
+        void close()
+        {
+            if (worker_.joinable())
+            {
+                {
+                    std::lock_guard lock{mutex_};
+                    stop_ = true;
+                }
+                wake_.notify_all();
+                worker_.join();
+            }
+
+            cache_.clear();
+            plan_.clear();
+            clip_.reset();
+        }
+
+        /**
+         * @brief Gets frame n, from the cache or by waiting for the background thread.
+         * @return The frame, or an empty pointer on error (see last_error()).
+         */
+        avs_video_frame_ptr get(int n)
+        {
+            if (!clip_)
+                return {};
+
+            n = std::clamp(n, 0, vi_.num_frames - 1);
+
+            std::unique_lock lock{mutex_};
+
+            ++stats_.requests;
+            const bool planned{std::find(plan_.begin(), plan_.end(), n) != plan_.end() || in_flight_ == n};
+            classify(n);
+            const cache_entry* entry{find(n)};
+            if (entry)
+                ++stats_.hits;
+            // Grow while the prefetches are used; fall back when they are not.
+            depth_ = (entry || planned) ? std::min(depth_ * 2, max_depth_) : min_depth;
+            replan(n);
+
+            if (!entry)
+            {
+                demand_ = n;
+                wake_.notify_all();
+                wake_.wait(lock, [&] { return (entry = find(n)) || error_frame_ == n || stop_; });
+                demand_ = -1;
+
+                if (!entry)
+                {
+                    last_error_ = (error_) ? error_ : "seek_reader: stopped.";
+                    // A later failure of another frame may already have replaced it.
+                    if (error_frame_ == n)
+                        error_frame_ = -1;
+                    return {};
+                }
+            }
+
+            return avs_video_frame_ptr{g_avs_api->avs_copy_video_frame(entry->frame.get())};
+        }
+
+        /**
+         * @brief Gets the access pattern detected at the last request.
+         */
+        access_pattern pattern() const
+        {
+            std::lock_guard lock{mutex_};
+            return pattern_;
+        }
+
+        statistics stats() const
+        {
+            std::lock_guard lock{mutex_};
+            return stats_;
+        }
+
+        const AVS_VideoInfo& video_info() const noexcept
+        {
+            return vi_;
+        }
+
+        /**
+         * @brief Gets the last error message. Empty if there was no error.
+         */
+        const std::string& last_error() const noexcept
+        {
+            return last_error_;
+        }
+
+    private:
+        static constexpr int min_depth{2};
+        static constexpr int history_length{8};
+        // Largest step still treated as playback (fast forward/rewind) rather than seeking.
+        static constexpr int max_stride{8};
+        static constexpr int scrub_distance{64};
+
+        struct cache_entry
+        {
+            int n;
+            avs_video_frame_ptr frame;
+        };
+
+        // Called with mutex_ held.
+        const cache_entry* find(int n) const
+        {
+            for (const cache_entry& e : cache_)
+            {
+                if (e.n == n)
+                    return &e;
+            }
+
+            return nullptr;
+        }
+
+        // Called with mutex_ held. Records n and classifies the deltas between the recent requests.
+        void classify(int n)
+        {
+            if (history_size_ == history_length)
+                std::move(history_.begin() + 1, history_.end(), history_.begin());
+            else
+                ++history_size_;
+            history_[history_size_ - 1] = n;
+            position_ = n;
+
+            if (history_size_ < 3)
+            {
+                stride_ = 1;
+                pattern_ = access_pattern::forward;
+                return;
+            }
+
+            const int deltas{history_size_ - 1};
+            const int last_delta{history_[deltas] - history_[deltas - 1]};
+            int same_stride{};
+            int near{};
+            int direction{};
+            for (int i{1}; i <= deltas; ++i)
+            {
+                const int d{history_[i] - history_[i - 1]};
+                same_stride += (d == last_delta);
+                near += (std::abs(d) <= scrub_distance);
+                direction += (d > 0) - (d < 0);
+            }
+
+            const access_pattern previous{pattern_};
+            if (last_delta != 0 && std::abs(last_delta) <= max_stride && same_stride * 4 >= deltas * 3)
+            {
+                stride_ = last_delta;
+                pattern_ = (last_delta > 0) ? access_pattern::forward : access_pattern::reverse;
+            }
+            else if (near * 4 >= deltas * 3)
+            {
+                stride_ = (direction < 0) ? -1 : 1;
+                pattern_ = access_pattern::scrub;
+            }
+            else
+                pattern_ = access_pattern::random;
+
+            if (pattern_ != previous)
+                depth_ = min_depth;
+        }
+
+        // Called with mutex_ held. Replaces the prefetch plan for position n.
+        void replan(int n)
+        {
+            std::deque<int> plan;
+            const auto add{[&](int f) {
+                if (f >= 0 && f < vi_.num_frames && !find(f) && f != in_flight_)
+                    plan.push_back(f);
+            }};
+
+            switch (pattern_)
+            {
+            case access_pattern::forward:
+            case access_pattern::reverse:
+                for (int i{1}; i <= depth_; ++i)
+                    add(n + i * stride_);
+                break;
+            case access_pattern::scrub:
+                // Neighbourhood, recent direction first.
+                for (int i{1}; i <= std::max(1, depth_ / 2); ++i)
+                {
+                    add(n + i * stride_);
+                    add(n - i * stride_);
+                }
+                break;
+            case access_pattern::random:
+                break;
+            }
+
+            for (const int f : plan_)
+            {
+                if (std::find(plan.begin(), plan.end(), f) == plan.end())
+                    ++stats_.cancelled;
+            }
+
+            plan_ = std::move(plan);
+            wake_.notify_all();
+        }
+
+        // Called with mutex_ held. Evicts the entry farthest from the current position.
+        void insert(int n, avs_video_frame_ptr frame)
+        {
+            if (static_cast<int>(cache_.size()) >= cache_capacity_)
+            {
+                const auto farthest{std::max_element(cache_.begin(), cache_.end(), [&](const cache_entry& a, const cache_entry& b) {
+                    return std::abs(a.n - position_) < std::abs(b.n - position_);
+                })};
+                cache_.erase(farthest);
+            }
+
+            cache_.push_back({n, std::move(frame)});
+        }
+
+        void fetch_loop()
+        {
+            std::unique_lock lock{mutex_};
+
+            for (;;)
+            {
+                wake_.wait(lock, [this] { return stop_ || (demand_ >= 0 && !find(demand_)) || !plan_.empty(); });
+                if (stop_)
+                    return;
+
+                int n{};
+                bool speculative{};
+                if (demand_ >= 0 && !find(demand_))
+                    n = demand_;
+                else
+                {
+                    n = plan_.front();
+                    plan_.pop_front();
+                    speculative = true;
+                    if (find(n))
+                        continue;
+                }
+
+                in_flight_ = n;
+                lock.unlock();
+                avs_video_frame_ptr frame{g_avs_api->avs_get_frame(clip_.get(), n)};
+                const char* error{(frame) ? nullptr : g_avs_api->avs_clip_get_error(clip_.get())};
+                lock.lock();
+                in_flight_ = -1;
+
+                if (frame)
+                {
+                    insert(n, std::move(frame));
+                    if (speculative)
+                        ++stats_.prefetched;
+                }
+                else if (!speculative)
+                {
+                    error_ = (error) ? error : "seek_reader: avs_get_frame failed.";
+                    error_frame_ = n;
+                    // Served (with the error): do not fetch the frame again for the same request.
+                    if (demand_ == n)
+                        demand_ = -1;
+                }
+
+                wake_.notify_all();
+            }
+        }
+
+        avs_clip_ptr clip_;
+        AVS_VideoInfo vi_{};
+        std::thread worker_;
+        mutable std::mutex mutex_;
+        std::condition_variable wake_;
+        std::vector<cache_entry> cache_;
+        std::deque<int> plan_;
+        std::array<int, history_length> history_{};
+        int history_size_{};
+        int position_{};
+        int stride_{1};
+        int depth_{min_depth};
+        int max_depth_{default_max_read_ahead};
+        int cache_capacity_{default_cache_frames};
+        int demand_{-1};
+        int in_flight_{-1};
+        int error_frame_{-1};
+        const char* error_{};
+        access_pattern pattern_{access_pattern::forward};
+        statistics stats_;
+        bool stop_{};
+        std::string last_error_;
+    };
+} // namespace avs_helpers
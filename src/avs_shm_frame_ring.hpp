@@ -0,0 +1,762 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+// Shared-memory frame ring for handing frames to another process (Linux: POSIX shm + futex).
+// The producer side (shm_frame_ring_writer) uses the loaded API; the consumer side (shm_frame_ring_reader)
+// only needs this header's layout and does not call into Avisynth.
+
+#pragma once
+
+#ifndef __linux__
+#error "avs_shm_frame_ring.hpp requires Linux (POSIX shared memory and futex)."
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "avs_c_api_loader.hpp"
+
+namespace avs_helpers
+{
+    namespace shm_ring
+    {
+        inline constexpr std::uint32_t magic{0x52534641}; // "AFSR"
+        inline constexpr std::uint32_t layout_version{3};
+        inline constexpr std::size_t alignment{64};
+
+        /**
+         * @brief Ring header at the start of the shared-memory object.
+         * write_index/read_index count published/consumed frames (modulo 2^32) and are also the futex words.
+         * consumer_pid is the pid of the process that has the ring open for reading (0 if none), as seen in its pid
+         * namespace consumer_pid_ns; consumer_start_time tells it apart from a later process that reuses the pid.
+         * The producer stops waiting on a full ring when that process no longer exists.
+         */
+        struct header
+        {
+            std::uint32_t magic;
+            std::uint32_t version;
+            std::uint32_t slot_count;
+            std::uint32_t plane_count;
+            std::uint64_t slot_size;
+            std::uint64_t props_capacity;
+            AVS_VideoInfo vi;
+            alignas(alignment) std::atomic<std::uint32_t> write_index;
+            alignas(alignment) std::atomic<std::uint32_t> read_index;
+            alignas(alignment) std::atomic<std::uint32_t> closed;
+            std::atomic<std::int32_t> consumer_pid;
+            std::atomic<std::uint64_t> consumer_pid_ns;
+            std::atomic<std::uint64_t> consumer_start_time;
+        };
+
+        /**
+         * @brief Per-plane layout inside a slot.
+         */
+        struct plane_info
+        {
+            std::uint64_t offset; // From the start of the slot.
+            std::int32_t plane;   // AVS_PLANAR_* id, 0 for packed/Y formats.
+            std::int32_t row_size;
+            std::int32_t height;
+            std::int32_t pitch;
+        };
+
+        /**
+         * @brief Slot header, followed by the plane data and the serialized frame properties.
+         */
+        struct slot_header
+        {
+            std::int32_t frame_number;
+            std::uint32_t props_size;
+            std::uint64_t props_offset; // From the start of the slot.
+            plane_info planes[4];
+        };
+
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+        static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+        constexpr std::size_t align_up(std::size_t v) noexcept
+        {
+            return (v + alignment - 1) & ~(alignment - 1);
+        }
+
+        inline std::size_t header_size() noexcept
+        {
+            return align_up(sizeof(header));
+        }
+
+        // Shared (not FUTEX_PRIVATE) operations, the words live in memory mapped by several processes.
+        inline void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected, const timespec* timeout) noexcept
+        {
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, expected, timeout, nullptr, 0);
+        }
+
+        inline void futex_wake(std::atomic<std::uint32_t>& word) noexcept
+        {
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+        }
+
+        /**
+         * @brief CLOCK_MONOTONIC deadline timeout_ms from now (unused if timeout_ms is negative).
+         */
+        inline timespec make_deadline(int timeout_ms) noexcept
+        {
+            timespec deadline{};
+            if (timeout_ms >= 0)
+            {
+                ::clock_gettime(CLOCK_MONOTONIC, &deadline);
+                deadline.tv_sec += timeout_ms / 1000;
+                deadline.tv_nsec += static_cast<long>(timeout_ms % 1000) * 1000000;
+                if (deadline.tv_nsec >= 1000000000)
+                {
+                    ++deadline.tv_sec;
+                    deadline.tv_nsec -= 1000000000;
+                }
+            }
+
+            return deadline;
+        }
+
+        /**
+         * @brief Gets the time left until deadline.
+         * @return false if the deadline has passed.
+         */
+        inline bool time_remaining(const timespec& deadline, timespec& remaining) noexcept
+        {
+            timespec now;
+            ::clock_gettime(CLOCK_MONOTONIC, &now);
+            const long long ns{(deadline.tv_sec - now.tv_sec) * 1000000000LL + (deadline.tv_nsec - now.tv_nsec)};
+            if (ns <= 0)
+                return false;
+
+            remaining.tv_sec = static_cast<time_t>(ns / 1000000000);
+            remaining.tv_nsec = static_cast<long>(ns % 1000000000);
+
+            return true;
+        }
+
+        /**
+         * @brief Gets the id (inode of /proc/self/ns/pid) of the caller's pid namespace.
+         * @return The id, or 0 if it cannot be read.
+         */
+        inline std::uint64_t pid_namespace() noexcept
+        {
+            struct stat st;
+            return (::stat("/proc/self/ns/pid", &st) == 0) ? static_cast<std::uint64_t>(st.st_ino) : 0;
+        }
+
+        /**
+         * @brief Gets the start time of a process in the caller's pid namespace (field 22 of /proc/<pid>/stat, in
+         * clock ticks since boot).
+         * @return The start time, or 0 if it cannot be read (errno is ENOENT if the process does not exist).
+         */
+        inline std::uint64_t process_start_time(std::int32_t pid) noexcept
+        {
+            char path[32];
+            std::snprintf(path, sizeof(path), "/proc/%d/stat", static_cast<int>(pid));
+            const int fd{::open(path, O_RDONLY | O_CLOEXEC)};
+            if (fd < 0)
+                return 0;
+
+            char buf[512];
+            const ssize_t n{::read(fd, buf, sizeof(buf) - 1)};
+            ::close(fd);
+            if (n <= 0)
+                return 0;
+            buf[n] = '\0';
+
+            // The command name (field 2) is in parentheses and may contain spaces and ')'.
+            const char* p{std::strrchr(buf, ')')};
+            if (!p)
+                return 0;
+            for (int field{2}; field < 22 && p; ++field)
+                p = std::strchr(p + 1, ' ');
+
+            return (p) ? std::strtoull(p + 1, nullptr, 10) : 0;
+        }
+
+        /**
+         * @brief Walks serialized frame properties.
+         * Record layout: u16 key length, key bytes, char type (AVS_PROPTYPE_INT/FLOAT/DATA), u32 element count,
+         * then int64 values, double values, or (u32 size, bytes) per data element.
+         * @param f Called as f(std::string_view key, char type, std::span<const std::byte> values) for each record,
+         * where values covers the record's element data.
+         */
+        template<typename F>
+        void for_each_prop(std::span<const std::byte> props, F&& f)
+        {
+            std::size_t pos{};
+            const auto read{[&](void* dst, std::size_t size) {
+                if (pos + size > props.size())
+                    return false;
+                std::memcpy(dst, props.data() + pos, size);
+                pos += size;
+                return true;
+            }};
+
+            while (pos < props.size())
+            {
+                std::uint16_t key_size;
+                if (!read(&key_size, sizeof(key_size)) || pos + key_size > props.size())
+                    return;
+                const std::string_view key{reinterpret_cast<const char*>(props.data() + pos), key_size};
+                pos += key_size;
+
+                char type;
+                std::uint32_t count;
+                if (!read(&type, 1) || !read(&count, sizeof(count)))
+                    return;
+
+                const std::size_t values_start{pos};
+                if (type == AVS_PROPTYPE_DATA)
+                {
+                    for (std::uint32_t i{0}; i < count; ++i)
+                    {
+                        std::uint32_t size;
+                        if (!read(&size, sizeof(size)) || pos + size > props.size())
+                            return;
+                        pos += size;
+                    }
+                }
+                else
+                {
+                    pos += static_cast<std::size_t>(count) * 8;
+                    if (pos > props.size())
+                        return;
+                }
+
+                f(key, type, props.subspan(values_start, pos - values_start));
+            }
+        }
+    } // namespace shm_ring
+
+    /**
+     * @brief Producer side of the shared-memory frame ring.
+     * Copies each frame's planes (rows packed to a 64-byte aligned pitch) and its int/float/data frame
+     * properties into the next free slot, then publishes it. Waits (futex) while the ring is full.
+     * Single producer.
+     */
+    class shm_frame_ring_writer
+    {
+    public:
+        shm_frame_ring_writer() = default;
+
+        ~shm_frame_ring_writer()
+        {
+            close();
+        }
+
+        shm_frame_ring_writer(const shm_frame_ring_writer&) = delete;
+        shm_frame_ring_writer& operator=(const shm_frame_ring_writer&) = delete;
+
+        /**
+         * @brief Creates the shared-memory object and initializes the ring.
+         * @param name POSIX shared-memory name (e.g. "/avs_preview"). An existing object is replaced.
+         * @param vi Video info of the frames that will be published.
+         * @param slot_count Number of frames the ring can hold.
+         * @param props_capacity Bytes reserved per slot for serialized frame properties.
+         * @return false on error (see last_error()).
+         */
+        bool create(const char* name, const AVS_VideoInfo& vi, std::uint32_t slot_count = 4, std::size_t props_capacity = 4096)
+        {
+            close();
+
+            shm_ring::slot_header layout{};
+            int planes[4];
+            const int num_planes{get_planes(vi, planes)};
+            std::size_t offset{shm_ring::align_up(sizeof(shm_ring::slot_header))};
+
+            for (int i{0}; i < num_planes; ++i)
+            {
+                const bool chroma{planes[i] == AVS_PLANAR_U || planes[i] == AVS_PLANAR_V};
+                const int row_size{g_avs_api->avs_row_size(&vi, planes[i])};
+                const int height{(chroma) ? vi.height >> g_avs_api->avs_get_plane_height_subsampling(&vi, planes[i]) : vi.height};
+
+                layout.planes[i] = {offset, planes[i], row_size, height, static_cast<std::int32_t>(shm_ring::align_up(row_size))};
+                offset += shm_ring::align_up(row_size) * height;
+            }
+
+            layout.props_offset = offset;
+            const std::size_t slot_size{shm_ring::align_up(offset + props_capacity)};
+            const std::size_t total_size{shm_ring::header_size() + slot_size * slot_count};
+
+            ::shm_unlink(name);
+            const int fd{::shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600)};
+            if (fd < 0)
+                return fail("shm_open");
+
+            if (::ftruncate(fd, static_cast<off_t>(total_size)) != 0)
+            {
+                ::close(fd);
+                ::shm_unlink(name);
+                return fail("ftruncate");
+            }
+
+            void* const base{::mmap(nullptr, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)};
+            ::close(fd);
+            if (base == MAP_FAILED)
+            {
+                ::shm_unlink(name);
+                return fail("mmap");
+            }
+
+            base_ = static_cast<std::byte*>(base);
+            size_ = total_size;
+            name_ = name;
+            layout_ = layout;
+            props_capacity_ = props_capacity;
+
+            header_ = new (base_) shm_ring::header{};
+            header_->slot_count = slot_count;
+            header_->plane_count = static_cast<std::uint32_t>(num_planes);
+            header_->slot_size = slot_size;
+            header_->props_capacity = props_capacity;
+            header_->vi = vi;
+            header_->version = shm_ring::layout_version;
+            pid_ns_ = shm_ring::pid_namespace();
+            std::atomic_thread_fence(std::memory_order_release);
+            std::atomic_ref<std::uint32_t>(header_->magic).store(shm_ring::magic, std::memory_order_release);
+
+            return true;
+        }
+
+        /**
+         * @brief Copies a frame into the next slot and publishes it. Waits while the ring is full.
+         * While waiting, the consumer registered by shm_frame_ring_reader::open() is checked for liveness every
+         * liveness_poll_ms, so a consumer that exits without closing the ring does not block the producer forever.
+         * @param env The AVS_ScriptEnvironment pointer (for reading frame properties).
+         * @param frame The frame. Its format must match the video info passed to create().
+         * @param frame_number Frame number stored with the slot.
+         * @param timeout_ms Maximum wait for a free slot in milliseconds, negative to wait indefinitely.
+         * @return false if the ring is closed or not created, on timeout, or if the consumer died (see last_error()).
+         */
+        bool publish(AVS_ScriptEnvironment* env, const AVS_VideoFrame* frame, int frame_number, int timeout_ms = -1)
+        {
+            if (!header_)
+                return false;
+
+            const std::uint32_t write{header_->write_index.load(std::memory_order_relaxed)};
+            const timespec deadline{shm_ring::make_deadline(timeout_ms)};
+            for (;;)
+            {
+                if (header_->closed.load(std::memory_order_acquire))
+                    return false;
+
+                const std::uint32_t read{header_->read_index.load(std::memory_order_acquire)};
+                if (write - read < header_->slot_count)
+                    break;
+
+                if (!consumer_alive())
+                {
+                    last_error_ = "shm_frame_ring_writer: the consumer exited without closing the ring.";
+                    return false;
+                }
+
+                timespec wait{0, liveness_poll_ms * 1000000L};
+                if (timeout_ms >= 0)
+                {
+                    timespec remaining;
+                    if (!shm_ring::time_remaining(deadline, remaining))
+                    {
+                        last_error_ = "shm_frame_ring_writer: timed out waiting for a free slot.";
+                        return false;
+                    }
+                    if (remaining.tv_sec == 0 && remaining.tv_nsec < wait.tv_nsec)
+                        wait = remaining;
+                }
+
+                shm_ring::futex_wait(header_->read_index, read, &wait);
+            }
+
+            std::byte* const slot{slot_ptr(write)};
+            shm_ring::slot_header sh{layout_};
+            sh.frame_number = frame_number;
+
+            for (std::uint32_t i{0}; i < header_->plane_count; ++i)
+            {
+                const shm_ring::plane_info& p{layout_.planes[i]};
+                const BYTE* src{g_avs_api->avs_get_read_ptr_p(frame, p.plane)};
+                const int src_pitch{g_avs_api->avs_get_pitch_p(frame, p.plane)};
+                std::byte* dst{slot + p.offset};
+
+                for (int y{0}; y < p.height; ++y)
+                    std::memcpy(dst + static_cast<std::ptrdiff_t>(y) * p.pitch, src + static_cast<std::ptrdiff_t>(y) * src_pitch, p.row_size);
+            }
+
+            sh.props_size = static_cast<std::uint32_t>(serialize_props(env, frame, slot + layout_.props_offset));
+            std::memcpy(slot, &sh, sizeof(sh));
+
+            header_->write_index.store(write + 1, std::memory_order_release);
+            shm_ring::futex_wake(header_->write_index);
+
+            return true;
+        }
+
+        /**
+         * @brief Publishes frames [first, last) of a clip.
+         * @param timeout_ms Maximum wait for a free slot per frame (see publish()).
+         * @return false if a frame could not be fetched or published (see last_error()) or the ring was closed.
+         */
+        bool publish_clip(AVS_ScriptEnvironment* env, const avs_clip_ptr& clip, int first, int last, int timeout_ms = -1)
+        {
+            for (int n{first}; n < last; ++n)
+            {
+                avs_video_frame_ptr frame{g_avs_api->avs_get_frame(clip.get(), n)};
+                if (!frame)
+                {
+                    const char* error{g_avs_api->avs_clip_get_error(clip.get())};
+                    last_error_ = (error) ? error : "shm_frame_ring_writer: avs_get_frame failed.";
+                    return false;
+                }
+
+                if (!publish(env, frame.get(), n, timeout_ms))
+                    return false;
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Marks the ring closed (waking the consumer), unmaps and unlinks it.
+         * Frames already published stay readable by consumers that have the object mapped.
+         */
+        void close()
+        {
+            if (!header_)
+                return;
+
+            header_->closed.store(1, std::memory_order_release);
+            shm_ring::futex_wake(header_->write_index);
+            shm_ring::futex_wake(header_->read_index);
+
+            ::munmap(base_, size_);
+            ::shm_unlink(name_.c_str());
+            header_ = nullptr;
+            base_ = nullptr;
+        }
+
+        /**
+         * @brief Gets the last error message. Empty if there was no error.
+         */
+        const std::string& last_error() const noexcept
+        {
+            return last_error_;
+        }
+
+    private:
+        static constexpr long liveness_poll_ms{100};
+
+        // false if a consumer is registered and its process no longer exists. A consumer whose pid namespace differs
+        // from the producer's (or is unknown) cannot be checked and counts as alive.
+        bool consumer_alive() const noexcept
+        {
+            const std::int32_t pid{header_->consumer_pid.load(std::memory_order_acquire)};
+            if (pid <= 0)
+                return true;
+
+            const std::uint64_t ns{header_->consumer_pid_ns.load(std::memory_order_relaxed)};
+            if (!ns || ns != pid_ns_)
+                return true;
+
+            const std::uint64_t start{shm_ring::process_start_time(pid)};
+            if (!start)
+                return errno != ENOENT;
+
+            // A different start time means the pid was reused by another process.
+            return start == header_->consumer_start_time.load(std::memory_order_relaxed);
+        }
+
+        std::byte* slot_ptr(std::uint32_t index) const noexcept
+        {
+            return base_ + shm_ring::header_size() + (index % header_->slot_count) * header_->slot_size;
+        }
+
+        // Writes int, float and data properties (clip and frame properties cannot cross processes).
+        // Properties that do not fit in props_capacity are dropped.
+        std::size_t serialize_props(AVS_ScriptEnvironment* env, const AVS_VideoFrame* frame, std::byte* dst) const
+        {
+            if (!g_avs_api->avs_get_frame_props_ro)
+                return 0;
+
+            const AVS_Map* props{g_avs_api->avs_get_frame_props_ro(env, frame)};
+            const int num_keys{g_avs_api->avs_prop_num_keys(env, props)};
+            std::size_t pos{};
+
+            for (int k{0}; k < num_keys; ++k)
+            {
+                const char* key{g_avs_api->avs_prop_get_key(env, props, k)};
+                const char type{g_avs_api->avs_prop_get_type(env, props, key)};
+                if (type != AVS_PROPTYPE_INT && type != AVS_PROPTYPE_FLOAT && type != AVS_PROPTYPE_DATA)
+                    continue;
+
+                const std::uint16_t key_size{static_cast<std::uint16_t>(std::strlen(key))};
+                const std::uint32_t count{static_cast<std::uint32_t>(g_avs_api->avs_prop_num_elements(env, props, key))};
+
+                std::size_t record_size{sizeof(key_size) + key_size + 1 + sizeof(count)};
+                if (type == AVS_PROPTYPE_DATA)
+                {
+                    for (std::uint32_t i{0}; i < count; ++i)
+                        record_size += sizeof(std::uint32_t) + g_avs_api->avs_prop_get_data_size(env, props, key, i, nullptr);
+                }
+                else
+                {
+                    record_size += static_cast<std::size_t>(count) * 8;
+                }
+
+                if (pos + record_size > props_capacity_)
+                    continue;
+
+                const auto write{[&](const void* src, std::size_t size) {
+                    std::memcpy(dst + pos, src, size);
+                    pos += size;
+                }};
+
+                write(&key_size, sizeof(key_size));
+                write(key, key_size);
+                write(&type, 1);
+                write(&count, sizeof(count));
+
+                for (std::uint32_t i{0}; i < count; ++i)
+                {
+                    if (type == AVS_PROPTYPE_INT)
+                    {
+                        const std::int64_t v{g_avs_api->avs_prop_get_int(env, props, key, i, nullptr)};
+                        write(&v, sizeof(v));
+                    }
+                    else if (type == AVS_PROPTYPE_FLOAT)
+                    {
+                        const double v{g_avs_api->avs_prop_get_float(env, props, key, i, nullptr)};
+                        write(&v, sizeof(v));
+                    }
+                    else
+                    {
+                        const std::uint32_t size{static_cast<std::uint32_t>(g_avs_api->avs_prop_get_data_size(env, props, key, i, nullptr))};
+                        write(&size, sizeof(size));
+                        write(g_avs_api->avs_prop_get_data(env, props, key, i, nullptr), size);
+                    }
+                }
+            }
+
+            return pos;
+        }
+
+        bool fail(const char* what)
+        {
+            last_error_ = "shm_frame_ring_writer: ";
+            last_error_ += what;
+            last_error_ += " failed: ";
+            last_error_ += std::strerror(errno);
+            return false;
+        }
+
+        std::byte* base_{};
+        std::size_t size_{};
+        shm_ring::header* header_{};
+        shm_ring::slot_header layout_{};
+        std::size_t props_capacity_{};
+        std::string name_;
+        std::uint64_t pid_ns_{};
+        std::string last_error_;
+    };
+
+    /**
+     * @brief Consumer side of the shared-memory frame ring. Does not use the Avisynth API.
+     * acquire() maps the oldest published slot in place (no copy); release() hands it back to the producer.
+     * Single consumer.
+     */
+    class shm_frame_ring_reader
+    {
+    public:
+        /**
+         * @brief View of an acquired slot. Valid until release().
+         */
+        struct frame
+        {
+            int frame_number;
+            const AVS_VideoInfo* vi;
+            int plane_count;
+            const shm_ring::plane_info* planes;
+            const std::byte* slot;
+            std::span<const std::byte> props; // See shm_ring::for_each_prop.
+
+            const std::byte* plane_data(int index) const noexcept
+            {
+                return slot + planes[index].offset;
+            }
+        };
+
+        shm_frame_ring_reader() = default;
+
+        ~shm_frame_ring_reader()
+        {
+            close();
+        }
+
+        shm_frame_ring_reader(const shm_frame_ring_reader&) = delete;
+        shm_frame_ring_reader& operator=(const shm_frame_ring_reader&) = delete;
+
+        /**
+         * @brief Maps an existing ring created by shm_frame_ring_writer.
+         * @return false on error (see last_error()).
+         */
+        bool open(const char* name)
+        {
+            close();
+
+            const int fd{::shm_open(name, O_RDWR, 0)};
+            if (fd < 0)
+                return fail("shm_open");
+
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < shm_ring::header_size())
+            {
+                ::close(fd);
+                last_error_ = "shm_frame_ring_reader: not a frame ring.";
+                return false;
+            }
+
+            void* const base{::mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)};
+            ::close(fd);
+            if (base == MAP_FAILED)
+                return fail("mmap");
+
+            base_ = static_cast<std::byte*>(base);
+            size_ = st.st_size;
+            header_ = reinterpret_cast<shm_ring::header*>(base_);
+
+            if (std::atomic_ref<std::uint32_t>(header_->magic).load(std::memory_order_acquire) != shm_ring::magic ||
+                header_->version != shm_ring::layout_version ||
+                shm_ring::header_size() + header_->slot_size * header_->slot_count > size_)
+            {
+                close();
+                last_error_ = "shm_frame_ring_reader: incompatible or uninitialized frame ring.";
+                return false;
+            }
+
+            const std::int32_t pid{static_cast<std::int32_t>(::getpid())};
+            header_->consumer_pid_ns.store(shm_ring::pid_namespace(), std::memory_order_relaxed);
+            header_->consumer_start_time.store(shm_ring::process_start_time(pid), std::memory_order_relaxed);
+            header_->consumer_pid.store(pid, std::memory_order_release);
+
+            return true;
+        }
+
+        /**
+         * @brief Waits for the next published frame.
+         * @param out Receives the view of the slot.
+         * @param timeout_ms Maximum wait in milliseconds, negative to wait indefinitely.
+         * @return false on timeout or when the producer closed the ring and all frames were consumed.
+         */
+        bool acquire(frame& out, int timeout_ms = -1)
+        {
+            if (!header_)
+                return false;
+
+            const std::uint32_t read{header_->read_index.load(std::memory_order_relaxed)};
+            const timespec deadline{shm_ring::make_deadline(timeout_ms)};
+
+            for (;;)
+            {
+                const std::uint32_t write{header_->write_index.load(std::memory_order_acquire)};
+                if (write != read)
+                    break;
+                if (header_->closed.load(std::memory_order_acquire))
+                    return false;
+
+                timespec remaining{};
+                if (timeout_ms >= 0 && !shm_ring::time_remaining(deadline, remaining))
+                    return false;
+
+                shm_ring::futex_wait(header_->write_index, write, (timeout_ms >= 0) ? &remaining : nullptr);
+            }
+
+            const std::byte* const slot{base_ + shm_ring::header_size() + (read % header_->slot_count) * header_->slot_size};
+            const auto* sh{reinterpret_cast<const shm_ring::slot_header*>(slot)};
+
+            out.frame_number = sh->frame_number;
+            out.vi = &header_->vi;
+            out.plane_count = static_cast<int>(header_->plane_count);
+            out.planes = sh->planes;
+            out.slot = slot;
+            out.props = {slot + sh->props_offset, (sh->props_size <= header_->props_capacity) ? sh->props_size : 0};
+
+            return true;
+        }
+
+        /**
+         * @brief Returns the slot obtained by the last acquire() to the producer.
+         */
+        void release()
+        {
+            if (!header_)
+                return;
+
+            header_->read_index.fetch_add(1, std::memory_order_release);
+            shm_ring::futex_wake(header_->read_index);
+        }
+
+        /**
+         * @brief Gets the video info published by the producer.
+         */
+        const AVS_VideoInfo* video_info() const noexcept
+        {
+            return (header_) ? &header_->vi : nullptr;
+        }
+
+        void close()
+        {
+            if (header_)
+            {
+                // Unregister, unless another consumer has opened the ring since.
+                std::int32_t pid{static_cast<std::int32_t>(::getpid())};
+                header_->consumer_pid.compare_exchange_strong(pid, 0, std::memory_order_acq_rel);
+            }
+
+            if (base_)
+                ::munmap(base_, size_);
+
+            base_ = nullptr;
+            header_ = nullptr;
+        }
+
+        /**
+         * @brief Gets the last error message. Empty if there was no error.
+         */
+        const std::string& last_error() const noexcept
+        {
+            return last_error_;
+        }
+
+    private:
+        bool fail(const char* what)
+        {
+            last_error_ = "shm_frame_ring_reader: ";
+            last_error_ += what;
+            last_error_ += " failed: ";
+            last_error_ += std::strerror(errno);
+            return false;
+        }
+
+        std::byte* base_{};
+        std::size_t size_{};
+        shm_ring::header* header_{};
+        std::string last_error_;
+    };
+} // namespace avs_helpers
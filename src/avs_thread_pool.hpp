@@ -0,0 +1,440 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "avs_mpmc_queue.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace avs_helpers
+{
+    namespace detail
+    {
+        struct cpu_topology_entry
+        {
+            int cpu;
+            int package;
+            int core;
+        };
+
+        /**
+         * @brief Gets the CPUs this process may run on (sched_getaffinity, so taskset and cpuset cgroups are
+         * respected), with their package and core ids. Empty where this is unknown.
+         */
+        inline std::vector<cpu_topology_entry> allowed_cpus()
+        {
+            std::vector<cpu_topology_entry> cpus;
+
+#ifdef __linux__
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (sched_getaffinity(0, sizeof(set), &set))
+                return cpus;
+
+            const auto read_id{[](int cpu, const char* name) {
+                std::ifstream file{"/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/" + name};
+                int id{-1};
+                file >> id;
+                return id;
+            }};
+
+            for (int cpu{0}; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &set))
+                    cpus.push_back({cpu, read_id(cpu, "physical_package_id"), read_id(cpu, "core_id")});
+            }
+#endif
+
+            return cpus;
+        }
+
+        /**
+         * @brief Gets the CPU limit of the cgroup v2 cpu.max quota, rounded up. 0 if there is no quota.
+         */
+        inline unsigned cgroup_cpu_quota()
+        {
+#ifdef __linux__
+            std::ifstream file{"/sys/fs/cgroup/cpu.max"};
+            std::string quota;
+            long long period{};
+            if (file >> quota >> period && quota != "max" && period > 0)
+            {
+                const long long q{std::atoll(quota.c_str())};
+                if (q > 0)
+                    return static_cast<unsigned>((q + period - 1) / period);
+            }
+#endif
+
+            return 0;
+        }
+    } // namespace detail
+
+    /**
+     * @brief Fixed-size worker pool for helper tasks, with CPU affinity and scheduling policy control.
+     * Tasks go through an mpmc_queue; submit() blocks while the queue is full.
+     */
+    class thread_pool
+    {
+    public:
+        enum class affinity
+        {
+            /** No pinning; workers inherit the process mask. The default worker count honours the mask and the
+                cgroup CPU quota. */
+            inherit,
+            /** One CPU per worker, filling the cores of one package (and their SMT siblings) first. */
+            compact,
+            /** One CPU per worker, spreading over packages and physical cores before SMT siblings. */
+            scatter,
+            /** One CPU per worker from config::cpus, round-robin. */
+            explicit_set
+        };
+
+        enum class sched_policy
+        {
+            normal,
+            /** SCHED_FIFO with config::fifo_priority. Needs CAP_SYS_NICE or an rtprio limit. */
+            fifo
+        };
+
+        struct config
+        {
+            /** 0 for the number of usable CPUs (see affinity::inherit). */
+            unsigned workers{0};
+            affinity pinning{affinity::inherit};
+            /** CPUs for affinity::explicit_set. CPUs outside the process mask are ignored. */
+            std::vector<int> cpus;
+            sched_policy policy{sched_policy::normal};
+            int fifo_priority{1};
+            /** Per-thread nice value for sched_policy::normal; 0 leaves it unchanged. */
+            int nice{0};
+            std::size_t queue_capacity{1024};
+        };
+
+        struct worker_stats
+        {
+            /** CPU the worker is pinned to; -1 if unpinned. */
+            int cpu;
+            /** false if the requested scheduling policy or nice value could not be applied. */
+            bool sched_applied;
+            std::uint64_t tasks;
+            std::uint64_t busy_ns;
+        };
+
+        struct statistics
+        {
+            std::uint64_t submitted{};
+            std::vector<worker_stats> workers;
+        };
+
+        thread_pool() = default;
+
+        explicit thread_pool(const config& cfg)
+        {
+            start(cfg);
+        }
+
+        ~thread_pool()
+        {
+            stop();
+        }
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        /**
+         * @brief Gets the process-wide pool, started with the default config on first use.
+         */
+        static thread_pool& shared()
+        {
+            static thread_pool pool{config{}};
+            return pool;
+        }
+
+        /**
+         * @brief (Re)starts the workers. Queued tasks of a previous start are finished first.
+         * @return false if the config selects no usable CPU (see last_error()).
+         */
+        bool start(const config& cfg)
+        {
+            stop();
+
+            std::vector<int> placement;
+            if (!plan_placement(cfg, placement))
+                return false;
+
+            queue_ = std::make_unique<mpmc_queue<std::function<void()>>>(cfg.queue_capacity);
+            stop_.store(false, std::memory_order_relaxed);
+            submitted_.store(0, std::memory_order_relaxed);
+            slots_ = std::make_unique<worker_slot[]>(placement.size());
+            worker_count_ = static_cast<unsigned>(placement.size());
+
+            threads_.reserve(placement.size());
+            for (std::size_t i{0}; i < placement.size(); ++i)
+            {
+                slots_[i].cpu = placement[i];
+                threads_.emplace_back([this, i, cfg] { worker_loop(slots_[i], cfg); });
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Finishes the queued tasks and joins the workers.
+         */
+        void stop()
+        {
+            if (threads_.empty())
+                return;
+
+            stop_.store(true, std::memory_order_release);
+            queue_->close();
+            for (std::thread& t : threads_)
+                t.join();
+
+            threads_.clear();
+        }
+
+        /**
+         * @brief Queues a task, waiting while the queue is full. Runs it inline if the pool is not started.
+         */
+        void submit(std::function<void()> task)
+        {
+            if (threads_.empty())
+            {
+                task();
+                return;
+            }
+
+            submitted_.fetch_add(1, std::memory_order_relaxed);
+            queue_->push(task, never_stop_);
+        }
+
+        /**
+         * @brief Runs f(i) for i in [0, count) on the workers and the calling thread, and waits for all of them.
+         * Must not be called from a worker of the same pool.
+         */
+        template<typename F>
+        void parallel_for(int count, F&& f)
+        {
+            if (count <= 0)
+                return;
+
+            // Shared so that helpers dequeued after the last index was taken still find valid counters;
+            // f is only called for indices below count, all of which finish before this returns.
+            struct state
+            {
+                std::atomic<int> next{0};
+                std::atomic<int> pending{0};
+            };
+            const auto st{std::make_shared<state>()};
+            st->pending.store(count, std::memory_order_relaxed);
+
+            const auto run{[st, count, fn = &f] {
+                for (int i{st->next.fetch_add(1, std::memory_order_relaxed)}; i < count; i = st->next.fetch_add(1, std::memory_order_relaxed))
+                {
+                    (*fn)(i);
+                    if (st->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                        st->pending.notify_all();
+                }
+            }};
+
+            const int helpers{std::min(count - 1, static_cast<int>(worker_count_))};
+            for (int h{0}; h < helpers; ++h)
+                submit(run);
+
+            run();
+
+            for (int left{st->pending.load(std::memory_order_acquire)}; left; left = st->pending.load(std::memory_order_acquire))
+                st->pending.wait(left, std::memory_order_acquire);
+        }
+
+        unsigned worker_count() const noexcept
+        {
+            return worker_count_;
+        }
+
+        statistics stats() const
+        {
+            statistics s;
+            s.submitted = submitted_.load(std::memory_order_relaxed);
+            for (unsigned i{0}; i < worker_count_; ++i)
+            {
+                s.workers.push_back({slots_[i].cpu, slots_[i].sched_applied.load(std::memory_order_relaxed),
+                    slots_[i].tasks.load(std::memory_order_relaxed), slots_[i].busy_ns.load(std::memory_order_relaxed)});
+            }
+
+            return s;
+        }
+
+        /**
+         * @brief Gets the last error message. Empty if there was no error.
+         */
+        const std::string& last_error() const noexcept
+        {
+            return last_error_;
+        }
+
+    private:
+        struct alignas(cache_line_size) worker_slot
+        {
+            int cpu{-1};
+            std::atomic<bool> sched_applied{true};
+            std::atomic<std::uint64_t> tasks{};
+            std::atomic<std::uint64_t> busy_ns{};
+        };
+
+        bool plan_placement(const config& cfg, std::vector<int>& placement)
+        {
+            std::vector<detail::cpu_topology_entry> cpus{detail::allowed_cpus()};
+
+            if (cfg.pinning == affinity::explicit_set)
+            {
+                std::erase_if(cpus, [&](const detail::cpu_topology_entry& c) {
+                    return std::find(cfg.cpus.begin(), cfg.cpus.end(), c.cpu) == cfg.cpus.end();
+                });
+                if (cpus.empty())
+                {
+                    last_error_ = "thread_pool: none of the requested CPUs is available to this process.";
+                    return false;
+                }
+            }
+            else if (cfg.pinning == affinity::compact)
+            {
+                std::stable_sort(cpus.begin(), cpus.end(), [](const auto& a, const auto& b) {
+                    return (a.package != b.package) ? a.package < b.package : a.core < b.core;
+                });
+            }
+            else if (cfg.pinning == affinity::scatter)
+            {
+                // Rank of each CPU among the SMT siblings of its core, then of its core within the package.
+                std::vector<std::pair<int, int>> rank(cpus.size());
+                for (std::size_t i{0}; i < cpus.size(); ++i)
+                {
+                    for (std::size_t j{0}; j < i; ++j)
+                    {
+                        if (cpus[j].package == cpus[i].package)
+                        {
+                            if (cpus[j].core == cpus[i].core)
+                                ++rank[i].first;
+                            else if (rank[j].first == 0)
+                                ++rank[i].second;
+                        }
+                    }
+                }
+
+                std::vector<std::size_t> order(cpus.size());
+                for (std::size_t i{0}; i < order.size(); ++i)
+                    order[i] = i;
+                std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+                    if (rank[a] != rank[b])
+                        return rank[a] < rank[b];
+                    return cpus[a].package < cpus[b].package;
+                });
+
+                std::vector<detail::cpu_topology_entry> sorted;
+                for (const std::size_t i : order)
+                    sorted.push_back(cpus[i]);
+                cpus = std::move(sorted);
+            }
+
+            unsigned workers{cfg.workers};
+            if (!workers)
+            {
+                workers = (cpus.empty()) ? std::max(1u, std::thread::hardware_concurrency()) : static_cast<unsigned>(cpus.size());
+                if (const unsigned quota{detail::cgroup_cpu_quota()}; quota && quota < workers)
+                    workers = quota;
+            }
+
+            const bool pin{cfg.pinning != affinity::inherit && !cpus.empty()};
+            placement.assign(workers, -1);
+            for (unsigned i{0}; pin && i < workers; ++i)
+                placement[i] = cpus[i % cpus.size()].cpu;
+
+            last_error_.clear();
+
+            return true;
+        }
+
+        static bool apply_thread_settings(int cpu, const config& cfg)
+        {
+            bool ok{true};
+
+#ifdef __linux__
+            if (cpu >= 0)
+            {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpu, &set);
+                ok &= pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+            }
+
+            if (cfg.policy == sched_policy::fifo)
+            {
+                sched_param param{};
+                param.sched_priority = cfg.fifo_priority;
+                ok &= pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+            }
+            else if (cfg.nice)
+                ok &= setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), cfg.nice) == 0;
+#else
+            ok = cpu < 0 && cfg.policy == sched_policy::normal && !cfg.nice;
+#endif
+
+            return ok;
+        }
+
+        void worker_loop(worker_slot& slot, const config& cfg)
+        {
+            slot.sched_applied.store(apply_thread_settings(slot.cpu, cfg), std::memory_order_relaxed);
+
+            std::function<void()> task;
+            for (;;)
+            {
+                if (!queue_->try_pop(task) && !queue_->pop(task, stop_))
+                {
+                    // Stopped: finish what is still queued.
+                    if (!queue_->try_pop(task))
+                        return;
+                }
+
+                const auto start{std::chrono::steady_clock::now()};
+                task();
+                task = nullptr;
+                slot.busy_ns.fetch_add(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                           std::chrono::steady_clock::now() - start)
+                                                                      .count()),
+                    std::memory_order_relaxed);
+                slot.tasks.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        std::unique_ptr<mpmc_queue<std::function<void()>>> queue_;
+        std::unique_ptr<worker_slot[]> slots_;
+        std::vector<std::thread> threads_;
+        unsigned worker_count_{};
+        std::atomic<bool> stop_{};
+        std::atomic<std::uint64_t> submitted_{};
+        std::string last_error_;
+        static inline const std::atomic<bool> never_stop_{false};
+    };
+} // namespace avs_helpers
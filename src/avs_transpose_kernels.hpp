@@ -0,0 +1,156 @@
+// Copyright (c) 2025 Asd-g
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "avs_cpu_dispatch.hpp"
+#include "avs_frame_view.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define AVS_HELPERS_TRANSPOSE_SSE2 1
+#else
+#define AVS_HELPERS_TRANSPOSE_SSE2 0
+#endif
+
+namespace avs_helpers
+{
+    namespace detail
+    {
+        // Tile side in samples: a source and a destination tile fit in 16 KiB of L1 together.
+        template<typename T>
+        inline constexpr int transpose_tile{(sizeof(T) == 4) ? 32 : 64};
+
+#if AVS_HELPERS_TRANSPOSE_SSE2
+        template<int E>
+        AVS_FORCEINLINE __m128i unpack_lo(__m128i a, __m128i b)
+        {
+            if constexpr (E == 1)
+                return _mm_unpacklo_epi8(a, b);
+            else if constexpr (E == 2)
+                return _mm_unpacklo_epi16(a, b);
+            else
+                return _mm_unpacklo_epi32(a, b);
+        }
+
+        template<int E>
+        AVS_FORCEINLINE __m128i unpack_hi(__m128i a, __m128i b)
+        {
+            if constexpr (E == 1)
+                return _mm_unpackhi_epi8(a, b);
+            else if constexpr (E == 2)
+                return _mm_unpackhi_epi16(a, b);
+            else
+                return _mm_unpackhi_epi32(a, b);
+        }
+
+        // One round of the block transpose: row pairs (i, i + N / 2) interleaved into rows 2i and 2i + 1.
+        template<int E, int N, std::size_t... I>
+        AVS_FORCEINLINE void transpose_round(__m128i (&r)[N], std::index_sequence<I...>)
+        {
+            const __m128i t[N]{((I & 1) ? unpack_hi<E>(r[I / 2], r[I / 2 + N / 2]) : unpack_lo<E>(r[I / 2], r[I / 2 + N / 2]))...};
+            ((r[I] = t[I]), ...);
+        }
+
+        // Transposes an N x N block, N = 16 / sizeof(T) (16x16 bytes, 8x8 words, 4x4 dwords), in registers:
+        // log2(N) rounds of interleaving rows i and i + N / 2 (a perfect shuffle of the rows each round).
+        // Index sequences keep the block fully unrolled at -O2.
+        template<typename T, std::size_t... I>
+        AVS_FORCEINLINE void transpose_block_sse2(
+            T* d, std::ptrdiff_t dst_pitch, const T* s, std::ptrdiff_t src_pitch, std::index_sequence<I...> rows)
+        {
+            constexpr int E{sizeof(T)};
+            constexpr int N{16 / E};
+
+            const auto* src{reinterpret_cast<const std::uint8_t*>(s)};
+            auto* dst{reinterpret_cast<std::uint8_t*>(d)};
+
+            __m128i r[N]{_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + static_cast<std::ptrdiff_t>(I) * src_pitch))...};
+
+            transpose_round<E>(r, rows);
+            transpose_round<E>(r, rows);
+            if constexpr (N >= 8)
+                transpose_round<E>(r, rows);
+            if constexpr (N == 16)
+                transpose_round<E>(r, rows);
+
+            (_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + static_cast<std::ptrdiff_t>(I) * dst_pitch), r[I]), ...);
+        }
+#endif
+
+        // Transposes the w x h region of src at (x0, y0) into dst at (y0, x0).
+        template<typename T>
+        AVS_FORCEINLINE void transpose_region(plane_view<T> dst, plane_view<const T> src, int x0, int y0, int w, int h)
+        {
+            int y{0};
+#if AVS_HELPERS_TRANSPOSE_SSE2
+            constexpr int N{16 / static_cast<int>(sizeof(T))};
+
+            for (; y + N <= h; y += N)
+            {
+                int x{0};
+                for (; x + N <= w; x += N)
+                    transpose_block_sse2(
+                        dst.row(x0 + x) + y0 + y, dst.pitch, src.row(y0 + y) + x0 + x, src.pitch, std::make_index_sequence<N>{});
+
+                for (; x < w; ++x)
+                {
+                    T* d{dst.row(x0 + x) + y0};
+                    for (int k{y}; k < y + N; ++k)
+                        d[k] = src.row(y0 + k)[x0 + x];
+                }
+            }
+#endif
+            for (; y < h; ++y)
+            {
+                const T* s{src.row(y0 + y) + x0};
+                for (int x{0}; x < w; ++x)
+                    dst.row(x0 + x)[y0 + y] = s[x];
+            }
+        }
+
+        template<typename T>
+        AVS_FORCEINLINE bool transpose_rows(plane_view<T> dst, plane_view<const T> src)
+        {
+            if (dst.width != src.height || dst.height != src.width)
+                return false;
+
+            constexpr int tile{transpose_tile<T>};
+            for (int y{0}; y < src.height; y += tile)
+            {
+                for (int x{0}; x < src.width; x += tile)
+                    transpose_region(dst, src, x, y, std::min(tile, src.width - x), std::min(tile, src.height - y));
+            }
+
+            return true;
+        }
+    } // namespace detail
+
+    /**
+     * @brief Transposes a plane: dst(x, y) = src(y, x).
+     * Works in L1-sized tiles, each transposed with 16x16 (8-bit), 8x8 (16-bit) or 4x4 (32-bit) register blocks.
+     * A separable filter can run its vertical pass as a horizontal pass: transpose into a scratch plane
+     * (e.g. arena_plane), filter its rows and transpose back.
+     * @param dst Plane of src.height x src.width samples; must not overlap src.
+     * @return false if the sizes do not match.
+     */
+    AVS_HELPERS_KERNEL inline bool transpose_plane(plane_view<std::uint8_t> dst, plane_view<const std::uint8_t> src)
+    {
+        return detail::transpose_rows(dst, src);
+    }
+
+    AVS_HELPERS_KERNEL inline bool transpose_plane(plane_view<std::uint16_t> dst, plane_view<const std::uint16_t> src)
+    {
+        return detail::transpose_rows(dst, src);
+    }
+
+    AVS_HELPERS_KERNEL inline bool transpose_plane(plane_view<float> dst, plane_view<const float> src)
+    {
+        return detail::transpose_rows(dst, src);
+    }
+} // namespace avs_helpers